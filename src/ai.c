@@ -0,0 +1,517 @@
+/** @file
+ * Implementation of the computer player of the game gamma
+ *
+ * The search is a Monte Carlo tree search with the UCT selection rule.
+ * All the threads share a single tree guarded by a mutex, but the random
+ * games (playouts), which take almost all the time, are played outside
+ * of the lock, each one on its own fork of the game.
+ * While a thread plays out a node, the node counts as a lost visit
+ * for the other threads (virtual loss), so they explore other moves.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+// If not defined, clock_gettime is not declared in C11 mode
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "ai.h"
+#include "gamma.h"
+#include "frontier.h"
+#include "types.c"
+
+/** @brief Exploration constant of the UCT rule
+ */
+#define EXPLORATION 1.4142135623730951
+
+/** @brief How many random fields a playout tries before it lists the moves
+ */
+#define SAMPLING_ATTEMPTS 32
+
+/** @brief Stores data of a single node of the search tree
+ *
+ * A node corresponds to the game state reached by playing
+ * the moves of all the nodes on the path from the root.
+ */
+typedef struct NodeData {
+    LegalMove move;              /**< Move leading to this node */
+    uint32_t player;             /**< Player who made @p move */
+    uint32_t to_move;            /**< Player to move in this node,
+                                      zero if the game is over */
+    bool initialized;            /**< Have @p to_move and @p untried
+                                      been computed yet */
+    LegalMove *untried;          /**< Moves without a child node yet */
+    uint32_t number_of_untried;  /**< Length of @p untried */
+    struct NodeData **children;  /**< Nodes of the tried moves */
+    uint32_t number_of_children; /**< Length of @p children */
+    struct NodeData *parent;     /**< NULL for the root */
+    double wins;                 /**< Sum of the results of @p player
+                                      in the playouts through this node */
+    uint64_t visits;             /**< Number of playouts through this node */
+    uint64_t virtual_loss;       /**< Number of playouts through this node
+                                      still in progress */
+} *Node;
+
+/** @brief Stores data shared by all the threads of a search
+ */
+typedef struct Search {
+    gamma_t *g;                  /**< Game state in the root,
+                                      read-only during the search */
+    Node root;                   /**< Root of the tree */
+    pthread_mutex_t lock;        /**< Guards the whole tree */
+    struct timespec deadline;    /**< When to stop the search */
+    uint64_t seed;               /**< Seed of the random generators */
+} Search;
+
+/** @brief Stores data of a single thread of a search
+ */
+typedef struct Worker {
+    Search *search;              /**< The search */
+    uint64_t random;             /**< State of the random generator */
+    pthread_t thread;            /**< The thread */
+} Worker;
+
+/** @brief Returns the next pseudorandom number (xorshift64*).
+ *
+ * @param state         – state of the generator, must not be zero
+ */
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state >> 12u;
+    *state ^= *state << 25u;
+    *state ^= *state >> 27u;
+    return *state * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+/** @brief Checks if the time of the search is up.
+ */
+static bool time_is_up(Search *search) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > search->deadline.tv_sec ||
+           (now.tv_sec == search->deadline.tv_sec &&
+            now.tv_nsec >= search->deadline.tv_nsec);
+}
+
+/** @brief Makes a move.
+ *
+ * @return @p true, if the move was made, @p false otherwise.
+ */
+static bool play(gamma_t *g, uint32_t player, LegalMove move) {
+    if (move.golden)
+        return gamma_golden_move(g, player, move.x, move.y);
+    else
+        return gamma_move(g, player, move.x, move.y);
+}
+
+/** @brief Returns the player moving after @p player.
+ *
+ * @return Index of the first player after @p player (cyclically)
+ *         who can make an ordinary move or zero if there's no such player.
+ */
+static uint32_t next_player(gamma_t *g, uint32_t player) {
+    for (uint32_t i = 1; i <= g->number_of_players; i++) {
+        uint32_t next = (uint32_t) (((uint64_t) player + i - 1) %
+                                    g->number_of_players) + 1;
+        if (gamma_free_fields(g, next) > 0)
+            return next;
+    }
+    return 0;
+}
+
+/** @brief Lists all the legal moves of a player.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – index of the player
+ * @param length        – where to save the number of moves
+ * @return Array of the moves (NULL if there are none)
+ *         or NULL if the allocation has failed.
+ */
+static LegalMove *list_moves(gamma_t *g, uint32_t player, uint32_t *length) {
+    *length = 0;
+
+    LegalMoves cursor = gamma_legal_moves(g, player);
+    if (cursor == NULL)
+        return NULL;
+
+    uint32_t capacity = 16;
+    LegalMove *result = malloc(capacity * sizeof(LegalMove));
+
+    while (result != NULL) {
+        if (*length == capacity) {
+            capacity *= 2;
+            LegalMove *larger = realloc(result, capacity * sizeof(LegalMove));
+            if (larger == NULL)
+                free(result);
+            result = larger;
+            continue;
+        }
+
+        uint32_t read = gamma_legal_moves_next(cursor, result + *length,
+                                               capacity - *length);
+        if (read == 0)
+            break;
+        *length += read;
+    }
+
+    gamma_legal_moves_delete(cursor);
+
+    if (result == NULL || *length == 0) {
+        free(result);
+        *length = 0;
+        return NULL;
+    }
+    return result;
+}
+
+/** @brief Allocates a node.
+ *
+ * @return Pointer to the node or NULL if the allocation has failed.
+ */
+static Node node_new(Node parent, uint32_t player, LegalMove move) {
+    Node result = calloc(1, sizeof(struct NodeData));
+    if (result != NULL) {
+        result->parent = parent;
+        result->player = player;
+        result->move = move;
+    }
+    return result;
+}
+
+/** @brief Computes the moves of a node.
+ *
+ * @param node          – the node
+ * @param to_move       – player to move in the node or zero
+ * @param g             – game state of the node
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool node_initialize(Node node, uint32_t to_move, gamma_t *g) {
+    node->to_move = to_move;
+    if (to_move != 0) {
+        node->untried = list_moves(g, to_move, &node->number_of_untried);
+        if (node->untried == NULL)
+            return false;
+
+        node->children = malloc(node->number_of_untried * sizeof(Node));
+        if (node->children == NULL) {
+            free(node->untried);
+            node->untried = NULL;
+            node->number_of_untried = 0;
+            return false;
+        }
+    }
+    node->initialized = true;
+    return true;
+}
+
+/** @brief Frees the node and all of its descendants from the memory.
+ */
+static void node_delete(Node node) {
+    if (node != NULL) {
+        for (uint32_t i = 0; i < node->number_of_children; i++)
+            node_delete(node->children[i]);
+        free(node->children);
+        free(node->untried);
+        free(node);
+    }
+}
+
+/** @brief Chooses the child to descend to according to the UCT rule.
+ *
+ * The playouts in progress count as lost.
+ */
+static Node best_child(Node node) {
+    double parent_visits = (double) (node->visits + node->virtual_loss);
+
+    Node result = NULL;
+    double best = -1;
+    for (uint32_t i = 0; i < node->number_of_children; i++) {
+        Node child = node->children[i];
+        double visits = (double) (child->visits + child->virtual_loss);
+        if (visits == 0)
+            return child;
+
+        double value = child->wins / visits +
+                       EXPLORATION * sqrt(log(parent_visits) / visits);
+        if (value > best) {
+            best = value;
+            result = child;
+        }
+    }
+    return result;
+}
+
+/** @brief Makes all the moves on the path from the root to @p node.
+ *
+ * @return False if a move has failed, true otherwise.
+ */
+static bool replay(gamma_t *g, Node node) {
+    uint64_t depth = 0;
+    for (Node i = node; i->parent != NULL; i = i->parent)
+        depth++;
+    if (depth == 0)
+        return true;
+
+    Node *path = malloc(depth * sizeof(Node));
+    if (path == NULL)
+        return false;
+
+    uint64_t j = depth;
+    for (Node i = node; i->parent != NULL; i = i->parent)
+        path[--j] = i;
+
+    bool result = true;
+    for (uint64_t k = 0; result && k < depth; k++)
+        result = play(g, path[k]->player, path[k]->move);
+
+    free(path);
+    return result;
+}
+
+/** @brief Makes a random ordinary move.
+ *
+ * Tries a few random candidates first, which nearly always succeeds,
+ * and only then lists all the moves.
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – player who can make an ordinary move
+ * @param random        – state of the random generator
+ * @return @p true, if a move was made, @p false otherwise.
+ */
+static bool random_move(gamma_t *g, uint32_t player, uint64_t *random) {
+    const OwnerData *owner = get_owner(g, player);
+    Frontier frontier = owner->frontier;
+    bool at_limit = owner->busy_areas >= g->max_areas;
+    uint64_t fields = (uint64_t) g->width * g->height;
+
+    for (int i = 0; i < SAMPLING_ATTEMPTS; i++) {
+        uint64_t cell;
+        if (at_limit) {
+            if (!frontier_slot(frontier,
+                               next_random(random) % frontier_capacity(frontier),
+                               &cell))
+                continue;
+        } else {
+            cell = next_random(random) % fields;
+            if (get_field_owner(g, cell_position(g, cell)) != 0)
+                continue;
+        }
+        Position position = cell_position(g, cell);
+        return gamma_move(g, player, position.x, position.y);
+    }
+
+    // Reservoir sampling over the ordinary moves
+    LegalMoves cursor = gamma_legal_moves(g, player);
+    if (cursor == NULL)
+        return false;
+
+    LegalMove buffer[64], chosen;
+    uint64_t seen = 0;
+    uint32_t read;
+    while ((read = gamma_legal_moves_next(cursor, buffer, 64)) > 0) {
+        for (uint32_t i = 0; i < read; i++) {
+            if (!buffer[i].golden && next_random(random) % ++seen == 0)
+                chosen = buffer[i];
+        }
+    }
+    gamma_legal_moves_delete(cursor);
+
+    return seen > 0 && play(g, player, chosen);
+}
+
+/** @brief Plays random moves until the end of the game.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – player to move or zero if the game is over
+ * @param random        – state of the random generator
+ */
+static void playout(gamma_t *g, uint32_t player, uint64_t *random) {
+    while (player != 0 && random_move(g, player, random))
+        player = next_player(g, player);
+}
+
+/** @brief Performs a single iteration of the search.
+ *
+ * Selects a node, expands it, plays it out and propagates the result.
+ * @param search        – the search
+ * @param random        – state of the random generator of the thread
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool iterate(Search *search, uint64_t *random) {
+    // Selection
+    pthread_mutex_lock(&search->lock);
+    Node node = search->root;
+    node->virtual_loss++;
+    while (node->initialized && node->number_of_untried == 0 &&
+           node->number_of_children > 0) {
+        node = best_child(node);
+        node->virtual_loss++;
+    }
+    bool initialized = node->initialized;
+    pthread_mutex_unlock(&search->lock);
+
+    gamma_t *state = gamma_fork(search->g);
+    bool result = state != NULL && replay(state, node);
+
+    // Listing the moves is expensive, so it's done outside of the lock
+    // and dropped if another thread has done it in the meantime
+    if (result && !initialized) {
+        struct NodeData computed = {.initialized = false};
+        result = node_initialize(&computed,
+                                 next_player(state, node->player), state);
+
+        pthread_mutex_lock(&search->lock);
+        if (result && !node->initialized) {
+            node->to_move = computed.to_move;
+            node->untried = computed.untried;
+            node->number_of_untried = computed.number_of_untried;
+            node->children = computed.children;
+            node->initialized = true;
+        } else {
+            free(computed.untried);
+            free(computed.children);
+        }
+        pthread_mutex_unlock(&search->lock);
+    }
+
+    // Expansion
+    Node child = NULL;
+    uint32_t to_move = 0;
+    if (result) {
+        pthread_mutex_lock(&search->lock);
+        to_move = node->to_move;
+        if (node->number_of_untried > 0) {
+            uint32_t i = next_random(random) % node->number_of_untried;
+            child = node_new(node, node->to_move, node->untried[i]);
+            if (child != NULL) {
+                node->untried[i] = node->untried[--node->number_of_untried];
+                node->children[node->number_of_children++] = child;
+                child->virtual_loss++;
+                node = child;
+            }
+        }
+        pthread_mutex_unlock(&search->lock);
+    }
+
+    if (result && child != NULL)
+        result = play(state, child->player, child->move);
+
+    // Playout
+    uint64_t max_fields = 0;
+    uint32_t winners = 0;
+    if (result) {
+        if (child != NULL)
+            playout(state, next_player(state, child->player), random);
+        else
+            playout(state, to_move, random);
+
+        for (uint32_t i = 1; i <= state->number_of_players; i++) {
+            uint64_t fields = gamma_busy_fields(state, i);
+            if (fields > max_fields) {
+                max_fields = fields;
+                winners = 0;
+            }
+            if (fields == max_fields)
+                winners++;
+        }
+    }
+
+    // Backpropagation
+    pthread_mutex_lock(&search->lock);
+    for (Node i = node; i != NULL; i = i->parent) {
+        i->virtual_loss--;
+        if (result) {
+            i->visits++;
+            if (i->parent != NULL &&
+                gamma_busy_fields(state, i->player) == max_fields)
+                i->wins += 1.0 / winners;
+        }
+    }
+    pthread_mutex_unlock(&search->lock);
+
+    gamma_delete(state);
+    return result;
+}
+
+/** @brief Runs the iterations of the search until the time is up.
+ *
+ * @param worker        – pointer to the Worker of the thread
+ * @return NULL
+ */
+static void *work(void *worker) {
+    Worker *data = worker;
+    do {
+        if (!iterate(data->search, &data->random))
+            break;
+    } while (!time_is_up(data->search));
+    return NULL;
+}
+
+bool gamma_ai_move(gamma_t *g, uint32_t player,
+                   uint32_t budget_ms, uint32_t threads) {
+    if (g == NULL || player == 0 || player > g->number_of_players)
+        return false;
+    if (threads == 0)
+        threads = 1;
+
+    Search search;
+    search.g = g;
+    search.seed = gamma_hash(g) ^ player;
+    search.root = node_new(NULL, 0, (LegalMove) {0, 0, false});
+    if (search.root == NULL)
+        return false;
+
+    if (!node_initialize(search.root, player, g) ||
+        search.root->number_of_untried == 0) {
+        node_delete(search.root);
+        return false;
+    }
+
+    // With a single legal move there's nothing to search for
+    if (search.root->number_of_untried > 1) {
+        clock_gettime(CLOCK_MONOTONIC, &search.deadline);
+        search.deadline.tv_sec += budget_ms / 1000;
+        search.deadline.tv_nsec += (long) (budget_ms % 1000) * 1000000;
+        if (search.deadline.tv_nsec >= 1000000000) {
+            search.deadline.tv_sec++;
+            search.deadline.tv_nsec -= 1000000000;
+        }
+        pthread_mutex_init(&search.lock, NULL);
+
+        Worker *workers = malloc(threads * sizeof(Worker));
+        uint32_t started = 0;
+        if (workers != NULL) {
+            for (uint32_t i = 0; i < threads; i++) {
+                workers[i].search = &search;
+                // The seed must not give a zero state
+                workers[i].random = (search.seed ^ i) | 1u;
+            }
+            // The calling thread is the first worker
+            for (started = 1; started < threads; started++)
+                if (pthread_create(&workers[started].thread, NULL,
+                                   work, &workers[started]) != 0)
+                    break;
+            work(&workers[0]);
+            for (uint32_t i = 1; i < started; i++)
+                pthread_join(workers[i].thread, NULL);
+            free(workers);
+        }
+
+        pthread_mutex_destroy(&search.lock);
+    }
+
+    // The most visited move is the most reliable one
+    Node root = search.root;
+    LegalMove chosen = root->untried[0];
+    if (root->number_of_children > 0) {
+        Node best = root->children[0];
+        for (uint32_t i = 1; i < root->number_of_children; i++)
+            if (root->children[i]->visits > best->visits)
+                best = root->children[i];
+        chosen = best->move;
+    }
+
+    node_delete(search.root);
+    return play(g, player, chosen);
+}
@@ -0,0 +1,37 @@
+/** @file
+ * Interface of the computer player of the game gamma
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef AI_H
+#define AI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+/** @brief Makes a move chosen by the computer.
+ *
+ * Chooses a move of @p player with Monte Carlo tree search
+ * and makes it (see @ref gamma_move and @ref gamma_golden_move).
+ * The search plays random games on forks of @p g
+ * (see @ref gamma_fork) in @p threads threads sharing a single tree.
+ *
+ * The players move in turns, skipping the ones who cannot make
+ * an ordinary move, and the game ends when nobody can make one.
+ * The players with the most fields win.
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – index of the player, positive number not greater
+ *                        than the value @p players given to @ref gamma_new
+ * @param budget_ms     – how long to search for, in milliseconds
+ * @param threads       – number of threads to search with,
+ *                        zero is treated as one
+ * @return @p true, if a move was made or @p false when the player has
+ *         no legal move, one of the parameters is invalid
+ *         or the allocation has failed.
+ */
+bool gamma_ai_move(gamma_t *g, uint32_t player,
+                   uint32_t budget_ms, uint32_t threads);
+
+#endif //AI_H
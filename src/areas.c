@@ -0,0 +1,522 @@
+/** @file
+ * Implementation of the registry of areas
+ *
+ * Every field of a player is labelled with the id of its area
+ * (@ref gamma_t.labels), the areas are stored in @ref gamma_t.areas
+ * under their ids. The areas of a player form a doubly linked list
+ * starting at @ref OwnerData.first_area, the unused ids form
+ * a singly linked list starting at @ref gamma_t.free_areas.
+ *
+ * A change of an owner is prepared first: the fields to be relabelled
+ * are collected and everything to be written is made private to the game.
+ * Then @ref set_owner is called and the registry is updated,
+ * which cannot fail anymore.
+ *
+ * Merging relabels the fields of all the areas but the largest one,
+ * so each field is relabelled at most log(fields) times by the moves.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdlib.h>
+#include "areas.h"
+#include "board.h"
+#include "pages.h"
+#include "trace.h"
+#include "types.c"
+
+/** @brief Maximal number of areas neighbouring a single field
+ */
+#define MAX_NEIGHBOURING_AREAS 4
+
+/** @brief Structure storing a prepared change of an owner
+ */
+typedef struct AreaChange {
+    uint64_t slot;              /**< Slot of the field */
+    uint32_t old_owner;         /**< Owner of the field before the change */
+    uint32_t new_owner;         /**< Owner of the field after the change */
+    uint32_t old_area;          /**< Id of the area of the field
+                                     before the change, zero if free */
+    uint32_t pieces;            /**< Number of the areas the rest
+                                     of @p old_area splits into */
+    uint64_t piece_ends[MAX_NEIGHBOURING_AREAS]; /**< The area number i
+                                     consists of the fields of
+                                     @p piece_fields from
+                                     piece_ends[i - 1] (or 0)
+                                     to piece_ends[i] */
+    Slots piece_fields;         /**< Fields of the split areas */
+    uint32_t largest_piece;     /**< Index of the split area
+                                     keeping the id @p old_area */
+    uint32_t joined[MAX_NEIGHBOURING_AREAS]; /**< Distinct ids of the areas
+                                     of @p new_owner neighbouring
+                                     the field */
+    uint32_t number_joined;     /**< Length of @p joined */
+    uint32_t survivor;          /**< Id from @p joined kept by
+                                     the merged area */
+    Slots merged_fields;        /**< Fields of the joined areas
+                                     other than @p survivor */
+} AreaChange;
+
+/** @brief Returns the id of the area of the field in a slot.
+ */
+static uint32_t get_label(gamma_t *g, uint64_t slot) {
+    return *(const uint32_t *) pages_read(g->labels, slot);
+}
+
+/** @brief Sets the id of the area of the field in a slot.
+ *
+ * The label must have been made private by @ref prepare_label.
+ */
+static void set_label(gamma_t *g, uint64_t slot, uint32_t id) {
+    *(uint32_t *) pages_write(g->labels, slot) = id;
+}
+
+/** @brief Makes sure @ref set_label won't fail for a slot.
+ *
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool prepare_label(gamma_t *g, uint64_t slot) {
+    return pages_write(g->labels, slot) != NULL;
+}
+
+/** @brief Returns the data of the area with id @p id.
+ *
+ * The data must not be modified through the returned pointer,
+ * see @ref edit_area.
+ */
+static const AreaData *get_area(gamma_t *g, uint32_t id) {
+    return pages_read(g->areas, id);
+}
+
+/** @brief Returns the data of the area with id @p id for modifying it.
+ *
+ * The data must have been made private by @ref prepare_area.
+ */
+static Area edit_area(gamma_t *g, uint32_t id) {
+    return pages_write(g->areas, id);
+}
+
+/** @brief Makes sure @ref edit_area won't fail for an id.
+ *
+ * Does nothing for id zero.
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool prepare_area(gamma_t *g, uint32_t id) {
+    return id == 0 || pages_write(g->areas, id) != NULL;
+}
+
+/** @brief Returns the number of ids, including the unused id zero.
+ *
+ * There are never more areas than fields.
+ */
+static uint64_t number_of_ids(gamma_t *g) {
+    uint64_t fields = (uint64_t) g->width * g->height;
+    return (fields < UINT32_MAX - 1 ? fields : UINT32_MAX - 1) + 1;
+}
+
+bool areas_new(gamma_t *g) {
+    uint64_t slots = g->stride * ((uint64_t) g->height + 2);
+    g->labels = pages_new(slots, sizeof(uint32_t), NULL, NULL);
+    g->areas = pages_new(number_of_ids(g), sizeof(AreaData), NULL, NULL);
+    g->free_areas = 0;
+    g->next_area = 1;
+    return g->labels != NULL && g->areas != NULL;
+}
+
+/** @brief Extends the bounding box of an area to contain a field.
+ */
+static void area_include(Area area, Position position) {
+    if (area->min_x > position.x)
+        area->min_x = position.x;
+    if (area->min_y > position.y)
+        area->min_y = position.y;
+    if (area->max_x < position.x)
+        area->max_x = position.x;
+    if (area->max_y < position.y)
+        area->max_y = position.y;
+}
+
+/** @brief Sets the size and the bounding box of an area to its fields.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param area          – the area
+ * @param fields        – slots of all the fields of the area
+ * @param count         – length of @p fields, positive
+ */
+static void area_measure(gamma_t *g, Area area, const uint64_t *fields,
+                         uint64_t count) {
+    Position first = slot_position(g, fields[0]);
+    area->size = count;
+    area->min_x = area->max_x = first.x;
+    area->min_y = area->max_y = first.y;
+    for (uint64_t i = 1; i < count; i++)
+        area_include(area, slot_position(g, fields[i]));
+}
+
+/** @brief Takes an unused id and adds it to the areas of a player.
+ *
+ * The id must have been made private by @ref prepare_ids.
+ * @return The id, the size and the bounding box of its area
+ *         are left to the caller.
+ */
+static uint32_t take_area(gamma_t *g, uint32_t player) {
+    uint32_t id = g->free_areas;
+    if (id != 0)
+        g->free_areas = get_area(g, id)->next;
+    else
+        id = g->next_area++;
+
+    Owner owner = edit_owner(g, player);
+    Area area = edit_area(g, id);
+    area->owner = player;
+    area->previous = 0;
+    area->next = owner->first_area;
+    if (owner->first_area != 0)
+        edit_area(g, owner->first_area)->previous = id;
+    owner->first_area = id;
+    return id;
+}
+
+/** @brief Removes an area from the areas of its owner and frees its id.
+ */
+static void release_area(gamma_t *g, uint32_t id) {
+    Area area = edit_area(g, id);
+    if (area->previous != 0)
+        edit_area(g, area->previous)->next = area->next;
+    else
+        edit_owner(g, area->owner)->first_area = area->next;
+    if (area->next != 0)
+        edit_area(g, area->next)->previous = area->previous;
+
+    *area = (AreaData) {.next = g->free_areas};
+    g->free_areas = id;
+}
+
+/** @brief Makes sure @p count calls of @ref take_area won't fail.
+ *
+ * Makes the first @p count unused ids private to the game.
+ * The ids released by a change are made private by the preparation
+ * releasing them, so they may be taken instead.
+ * @return False if the allocation has failed
+ *         or there are not enough ids, true otherwise.
+ */
+static bool prepare_ids(gamma_t *g, uint32_t count) {
+    uint32_t id = g->free_areas;
+    uint64_t next = g->next_area;
+    for (uint32_t i = 0; i < count; i++) {
+        if (id != 0) {
+            if (!prepare_area(g, id))
+                return false;
+            id = get_area(g, id)->next;
+        } else {
+            if (next >= number_of_ids(g) || !prepare_area(g, next))
+                return false;
+            next++;
+        }
+    }
+    return true;
+}
+
+/** @brief Makes sure @ref release_area won't fail for an id.
+ */
+static bool prepare_release(gamma_t *g, uint32_t id) {
+    return prepare_area(g, id) &&
+           prepare_area(g, get_area(g, id)->previous) &&
+           prepare_area(g, get_area(g, id)->next);
+}
+
+/** @brief Lists the areas a pawn placed on a field would join.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @param player        – index of the player
+ * @param ids           – array of @ref MAX_NEIGHBOURING_AREAS elements
+ *                        where the distinct ids are saved
+ * @return Number of the ids, see @ref areas_joined.
+ */
+static uint32_t joined_areas(gamma_t *g, uint64_t slot, uint32_t player,
+                             uint32_t *ids) {
+    uint32_t result = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t neighbour = slot + g->neighbour_offsets[i];
+        if (slot_owner(g, neighbour) == player) {
+            uint32_t id = get_label(g, neighbour);
+            bool is_new = true;
+            for (uint32_t j = 0; j < result; j++)
+                if (ids[j] == id)
+                    is_new = false;
+            if (is_new)
+                ids[result++] = id;
+        }
+    }
+    return result;
+}
+
+/** @brief Prepares the removal of the pawn of the old owner.
+ *
+ * Collects the areas the area of the field splits into.
+ * @param g             – pointer to the structure storing the game state
+ * @param change        – the change being prepared
+ * @param ids           – number of the ids to be taken, updated
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool prepare_removal(gamma_t *g, AreaChange *change, uint32_t *ids) {
+    uint64_t slot = change->slot;
+    change->old_area = get_label(g, slot);
+
+    bool result = prepare_area(g, change->old_area);
+    for (int i = 0; i < 4 && result; i++) {
+        uint64_t neighbour = slot + g->neighbour_offsets[i];
+        if (slot_owner(g, neighbour) == change->old_owner) {
+            uint64_t begin = change->pieces == 0 ? 0 :
+                             change->piece_ends[change->pieces - 1];
+            result = collect_area(g, neighbour, slot, &change->piece_fields);
+            if (result && change->piece_fields.count > begin)
+                change->piece_ends[change->pieces++] =
+                        change->piece_fields.count;
+        }
+    }
+    unmark_fields(g, &change->piece_fields);
+    if (!result)
+        return false;
+
+    uint64_t largest_size = 0;
+    for (uint32_t i = 0; i < change->pieces; i++) {
+        uint64_t begin = i == 0 ? 0 : change->piece_ends[i - 1];
+        if (change->piece_ends[i] - begin > largest_size) {
+            largest_size = change->piece_ends[i] - begin;
+            change->largest_piece = i;
+        }
+    }
+
+    if (change->pieces == 0)
+        return prepare_release(g, change->old_area);
+
+    *ids += change->pieces - 1;
+    for (uint32_t i = 0; i < change->pieces; i++) {
+        uint64_t begin = i == 0 ? 0 : change->piece_ends[i - 1];
+        for (uint64_t j = begin; j < change->piece_ends[i] &&
+                                 i != change->largest_piece; j++)
+            if (!prepare_label(g, change->piece_fields.slots[j]))
+                return false;
+    }
+    return change->pieces == 1 ||
+           prepare_area(g, get_owner(g, change->old_owner)->first_area);
+}
+
+/** @brief Prepares placing the pawn of the new owner.
+ *
+ * Collects the areas to be merged into the largest joined one.
+ * @param g             – pointer to the structure storing the game state
+ * @param change        – the change being prepared
+ * @param ids           – number of the ids to be taken, updated
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool prepare_addition(gamma_t *g, AreaChange *change, uint32_t *ids) {
+    uint64_t slot = change->slot;
+    uint32_t player = change->new_owner;
+    change->number_joined = joined_areas(g, slot, player, change->joined);
+
+    if (change->number_joined == 0) {
+        *ids += 1;
+        return prepare_area(g, get_owner(g, player)->first_area);
+    }
+
+    uint64_t largest_size = 0;
+    for (uint32_t i = 0; i < change->number_joined; i++) {
+        uint64_t size = get_area(g, change->joined[i])->size;
+        if (size > largest_size) {
+            largest_size = size;
+            change->survivor = change->joined[i];
+        }
+    }
+
+    bool result = prepare_area(g, change->survivor);
+    for (int i = 0; i < 4 && result; i++) {
+        uint64_t neighbour = slot + g->neighbour_offsets[i];
+        if (slot_owner(g, neighbour) == player &&
+            get_label(g, neighbour) != change->survivor)
+            result = collect_area(g, neighbour, slot, &change->merged_fields);
+    }
+    unmark_fields(g, &change->merged_fields);
+
+    for (uint32_t i = 0; i < change->number_joined && result; i++)
+        if (change->joined[i] != change->survivor)
+            result = prepare_release(g, change->joined[i]);
+    for (uint64_t i = 0; i < change->merged_fields.count && result; i++)
+        result = prepare_label(g, change->merged_fields.slots[i]);
+    return result;
+}
+
+/** @brief Prepares the change of the owner of a field.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of the field
+ * @param new_owner     – zero or the index of the player
+ * @param change        – where to store the prepared change,
+ *                        must be freed with @ref change_free
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool prepare_change(gamma_t *g, uint64_t slot, uint32_t new_owner,
+                           AreaChange *change) {
+    *change = (AreaChange) {.slot = slot, .old_owner = slot_owner(g, slot),
+                            .new_owner = new_owner};
+
+    uint32_t ids = 0;
+    if (!prepare_label(g, slot) ||
+        (change->old_owner != 0 && !prepare_removal(g, change, &ids)) ||
+        (new_owner != 0 && !prepare_addition(g, change, &ids)))
+        return false;
+
+    // The id of a captured area of a single field is released
+    // before the new owner takes one, and is taken first
+    if (change->old_owner != 0 && change->pieces == 0 && ids > 0)
+        ids--;
+    return prepare_ids(g, ids);
+}
+
+/** @brief Updates the registry with a prepared change.
+ *
+ * The owner of the field must have been changed already.
+ * @param g             – pointer to the structure storing the game state
+ * @param change        – the change prepared by @ref prepare_change
+ */
+static void commit_change(gamma_t *g, AreaChange *change) {
+    set_label(g, change->slot, 0);
+
+    if (change->old_owner != 0) {
+        if (change->pieces == 0)
+            release_area(g, change->old_area);
+
+        for (uint32_t i = 0; i < change->pieces; i++) {
+            uint64_t begin = i == 0 ? 0 : change->piece_ends[i - 1];
+            uint64_t count = change->piece_ends[i] - begin;
+            const uint64_t *fields = change->piece_fields.slots + begin;
+
+            uint32_t id = change->old_area;
+            if (i != change->largest_piece) {
+                id = take_area(g, change->old_owner);
+                for (uint64_t j = 0; j < count; j++)
+                    set_label(g, fields[j], id);
+            }
+            area_measure(g, edit_area(g, id), fields, count);
+        }
+
+        edit_owner(g, change->old_owner)->busy_areas +=
+                (int64_t) change->pieces - 1;
+    }
+
+    if (change->new_owner != 0) {
+        Position position = slot_position(g, change->slot);
+        uint32_t id = change->survivor;
+        if (change->number_joined == 0) {
+            id = take_area(g, change->new_owner);
+            area_measure(g, edit_area(g, id), &change->slot, 1);
+        } else {
+            Area area = edit_area(g, id);
+            for (uint32_t i = 0; i < change->number_joined; i++) {
+                if (change->joined[i] != id) {
+                    const AreaData *joined = get_area(g, change->joined[i]);
+                    Position min = {joined->min_x, joined->min_y};
+                    Position max = {joined->max_x, joined->max_y};
+                    area->size += joined->size;
+                    area_include(area, min);
+                    area_include(area, max);
+                    release_area(g, change->joined[i]);
+                }
+            }
+            for (uint64_t i = 0; i < change->merged_fields.count; i++)
+                set_label(g, change->merged_fields.slots[i], id);
+            area->size++;
+            area_include(area, position);
+        }
+        set_label(g, change->slot, id);
+
+        edit_owner(g, change->new_owner)->busy_areas +=
+                1 - (int64_t) change->number_joined;
+    }
+}
+
+/** @brief Frees the fields collected by @ref prepare_change.
+ */
+static void change_free(AreaChange *change) {
+    slots_free(&change->piece_fields);
+    slots_free(&change->merged_fields);
+}
+
+uint32_t areas_joined(gamma_t *g, uint64_t slot, uint32_t player) {
+    uint32_t ids[MAX_NEIGHBOURING_AREAS];
+    return joined_areas(g, slot, player, ids);
+}
+
+bool areas_set_owner(gamma_t *g, uint64_t slot, uint32_t new_owner) {
+    AreaChange change;
+    bool result = prepare_change(g, slot, new_owner, &change) &&
+                  set_owner(g, slot, new_owner);
+    if (result)
+        commit_change(g, &change);
+    change_free(&change);
+    return result;
+}
+
+uint32_t areas_next(gamma_t *g, uint32_t area) {
+    return get_area(g, area)->next;
+}
+
+uint32_t gamma_area_id(gamma_t *g, uint32_t x, uint32_t y) {
+    if (g == NULL || x >= g->width || y >= g->height)
+        return 0;
+
+    Position position = {x, y};
+    return get_label(g, field_slot(g, position));
+}
+
+bool gamma_area(gamma_t *g, uint32_t area, GammaArea *out) {
+    if (g == NULL || out == NULL || area == 0 || area >= g->next_area)
+        return false;
+
+    const AreaData *data = get_area(g, area);
+    if (data->owner == 0)
+        return false;
+
+    out->player = data->owner;
+    out->size = data->size;
+    out->min_x = data->min_x;
+    out->min_y = data->min_y;
+    out->max_x = data->max_x;
+    out->max_y = data->max_y;
+    return true;
+}
+
+uint32_t gamma_player_areas(gamma_t *g, uint32_t player,
+                            uint32_t *areas, uint32_t size) {
+    if (g == NULL || player == 0 || player > g->number_of_players)
+        return 0;
+
+    uint32_t result = 0;
+    uint32_t id = get_owner(g, player)->first_area;
+    while (id != 0) {
+        if (result < size)
+            areas[result] = id;
+        result++;
+        id = get_area(g, id)->next;
+    }
+    return result;
+}
+
+uint64_t gamma_largest_area(gamma_t *g, uint32_t player) {
+    if (g == NULL || player == 0 || player > g->number_of_players)
+        return 0;
+
+    uint64_t start = trace_begin();
+    uint64_t result = 0;
+    uint32_t id = get_owner(g, player)->first_area;
+    while (id != 0) {
+        const AreaData *area = get_area(g, id);
+        if (area->size > result)
+            result = area->size;
+        id = area->next;
+    }
+    trace_end("gamma_largest_area", start);
+    return result;
+}
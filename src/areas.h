@@ -0,0 +1,127 @@
+/** @file
+ * Interface of the registry of areas
+ *
+ * The engine keeps every area of every player (see
+ * @ref are_in_the_same_area) under an id, with its size
+ * and bounding box. The registry is updated with each change
+ * of an owner: placing a pawn creates an area or merges
+ * the areas it touches, losing a pawn to a golden move
+ * shrinks its area or splits it into up to four areas.
+ *
+ * An area keeps its id as long as it exists. When areas merge,
+ * the largest one keeps its id. When an area splits, its largest
+ * part keeps the id and the other parts get new ones.
+ * Ids of areas that no longer exist are reused.
+ *
+ * Implementation:
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef AREAS_H
+#define AREAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+/** @brief Structure storing the data of a single area
+ */
+typedef struct GammaArea {
+    uint32_t player;    /**< Index of the player owning the area */
+    uint64_t size;      /**< Number of the fields of the area */
+    uint32_t min_x;     /**< Smallest column of its fields */
+    uint32_t min_y;     /**< Smallest row of its fields */
+    uint32_t max_x;     /**< Largest column of its fields */
+    uint32_t max_y;     /**< Largest row of its fields */
+} GammaArea;
+
+/** @brief Creates the empty registry of a new game.
+ *
+ * Sets @ref gamma_t.labels, @ref gamma_t.areas and the ids.
+ * @ref gamma_t.board must be created.
+ * @param g             – pointer to the structure storing the game state
+ * @return False if the allocation has failed, true otherwise.
+ *         The arrays are NULL or must be freed in both cases.
+ */
+bool areas_new(gamma_t *g);
+
+/** @brief Counts the areas a pawn placed on a field would join.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @param player        – index of the player
+ * @return Number of the distinct areas of @p player
+ *         containing a neighbour of the field, in range [0, 4].
+ */
+uint32_t areas_joined(gamma_t *g, uint64_t slot, uint32_t player);
+
+/** @brief Changes the owner of the field and updates the registry.
+ *
+ * Calls @ref set_owner and updates the areas of the old
+ * and the new owner, including @ref OwnerData.busy_areas.
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @param new_owner     – zero or the index of the player,
+ *                        different from the old owner
+ * @return False if the allocation has failed
+ *         (in which case nothing is changed), true otherwise.
+ */
+bool areas_set_owner(gamma_t *g, uint64_t slot, uint32_t new_owner);
+
+/** @brief Returns the id of the next area of the same player.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param area          – id of an existing area
+ * @return Id of the area following @p area in the list of its player
+ *         (see @ref gamma_player_areas), zero if it's the last one.
+ */
+uint32_t areas_next(gamma_t *g, uint32_t area);
+
+/** @brief Returns the id of the area of a field.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param x             – index of the column
+ * @param y             – index of the row
+ * @return Id of the area containing the field (@p x, @p y)
+ *         or zero if the field is free or one of the parameters
+ *         is invalid.
+ */
+uint32_t gamma_area_id(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Reads the data of an area.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param area          – id of the area, see @ref gamma_area_id
+ * @param[out] out      – where to store the data
+ * @return @p true, if the data has been stored, @p false if
+ * @p area is not an id of an existing area or one of the parameters
+ * is invalid.
+ */
+bool gamma_area(gamma_t *g, uint32_t area, GammaArea *out);
+
+/** @brief Lists the areas of a player.
+ *
+ * Most recently created areas come first.
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – index of the player, positive number not greater
+ *                        than the value @p players given to @ref gamma_new
+ * @param[out] areas    – array where the ids of the areas are saved,
+ *                        may be NULL if @p size == 0
+ * @param size          – length of @p areas
+ * @return Number of the areas of @p player, which may exceed @p size,
+ *         or zero if one of the parameters is invalid.
+ */
+uint32_t gamma_player_areas(gamma_t *g, uint32_t player,
+                            uint32_t *areas, uint32_t size);
+
+/** @brief Returns the size of the largest area of a player.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – index of the player, positive number not greater
+ *                        than the value @p players given to @ref gamma_new
+ * @return Number of the fields of the largest area of @p player,
+ *         zero if he has no areas or one of the parameters is invalid.
+ */
+uint64_t gamma_largest_area(gamma_t *g, uint32_t player);
+
+#endif //AREAS_H
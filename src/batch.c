@@ -7,40 +7,218 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
 #include "batch.h"
+#include "types.c"
 
-bool batch(gamma_t *g, char command, uint32_t *args, uint32_t numberOfArgs) {
+/** @brief Prints which fields of a rectangle a player may take
+ * Prints a row of the rectangle per line, from the top one,
+ * 1 for a field where the player may make an ordinary
+ * or a golden move and 0 otherwise. Only the part of the rectangle
+ * lying on the board is printed, so the work is bounded by the size
+ * of the board. Checks the moves on as many threads as @ref gamma_board,
+ * see @ref gamma_set_threads.
+ * @param g             - pointer to the structure storing the game state.
+ * @param player        - index of the player
+ * @param x             - column of the lower left field of the rectangle
+ * @param y             - row of the lower left field of the rectangle
+ * @param width         - number of the columns of the rectangle, positive
+ * @param height        - number of the rows of the rectangle, positive
+ * @param out           - where to print
+ * @return false if the allocation has failed, a parameter is invalid
+ * or the rectangle lies outside the board, true otherwise
+ */
+static bool check_rectangle(gamma_t *g, uint32_t player, uint32_t x,
+                            uint32_t y, uint32_t width, uint32_t height,
+                            FILE *out) {
+    if (g == NULL || width == 0 || height == 0 ||
+        x >= g->width || y >= g->height)
+        return false;
+
+    // Clip the rectangle to the board
+    if (width > g->width - x)
+        width = g->width - x;
+    if (height > g->height - y)
+        height = g->height - y;
+
+    // Each field is both an ordinary and a golden move,
+    // at most one of them is legal
+    uint64_t count = 2 * (uint64_t) width * height;
+    LegalMove *moves = NULL;
+    bool *results = NULL;
+    if (count <= SIZE_MAX / sizeof(LegalMove)) {
+        moves = malloc(count * sizeof(LegalMove));
+        results = malloc(count * sizeof(bool));
+    }
+    if (moves == NULL || results == NULL) {
+        free(moves);
+        free(results);
+        return false;
+    }
+
+    uint64_t i = 0;
+    for (uint32_t row = 0; row < height; row++) {
+        for (uint32_t column = 0; column < width; column++) {
+            for (int golden = 0; golden <= 1; golden++) {
+                moves[i].x = x + column;
+                moves[i].y = y + height - 1 - row;
+                moves[i].golden = golden;
+                i++;
+            }
+        }
+    }
+
+    bool correct = gamma_check_moves(g, player, moves, count, results,
+                                     g->threads);
+    if (correct) {
+        for (i = 0; i < count; i += 2) {
+            fputc(results[i] || results[i + 1] ? '1' : '0', out);
+            if ((i / 2) % width == width - 1)
+                fputc('\n', out);
+        }
+    }
+
+    free(moves);
+    free(results);
+    return correct;
+}
+
+/** @brief Converts string to uint32_t
+ * The function tries to convert @p str to uint32_t. If it suceeds,
+ * the result is saved in @p output
+ * @param str           - string to be converted
+ * @param output        - where to save the output
+ * @return true if the conversion was successful, false otherwise
+ */
+static bool strToInt(char *str, uint32_t *output) {
+    if (str == NULL)
+        return false;
+
+    uint64_t result = 0;
+    while (*str != '\0') {
+        if (*str >= '0' && *str <= '9' && result <= UINT32_MAX)
+            result = 10 * result + (*str - '0');
+        else
+            return false;
+        str++;
+    }
+    if (result <= UINT32_MAX)
+        *output = result;
+    return result <= UINT32_MAX;
+}
+
+bool parseCommand(char *line, char *command, uint32_t *args,
+                  uint32_t *numberOfArgs) {
+    // The command, the arguments and one more token to notice too many
+    char *tokens[MAX_NUMBER_OF_ARGS + 2];
+    uint32_t numberOfTokens = 0;
+
+    while (*line != '\0' && numberOfTokens < MAX_NUMBER_OF_ARGS + 2) {
+        // Skip all whitespace characters
+        while (*line != '\0' && isspace(*line)) {
+            *line = '\0';
+            line++;
+        }
+
+        // Save position
+        if (*line != '\0')
+            tokens[numberOfTokens++] = line;
+
+        // Skip all non-whitespace characters
+        while (*line != '\0' && !isspace(*line))
+            line++;
+    }
+
+    if (numberOfTokens == 0 || numberOfTokens > MAX_NUMBER_OF_ARGS + 1 ||
+        strlen(tokens[0]) != 1)
+        return false;
+
+    *command = tokens[0][0];
+    *numberOfArgs = numberOfTokens - 1;
+    for (uint32_t i = 0; i < *numberOfArgs; i++)
+        if (!strToInt(tokens[i + 1], &args[i]))
+            return false;
+    return true;
+}
+
+bool batch(gamma_t *g, char command, uint32_t *args, uint32_t numberOfArgs,
+           FILE *out) {
     switch (command) {
         case 'm':
             if (numberOfArgs != 3)
                 return false;
-            printf("%i\n", gamma_move(g, args[0], args[1], args[2]));
+            fprintf(out, "%i\n", gamma_move(g, args[0], args[1], args[2]));
             break;
         case 'g':
             if (numberOfArgs != 3)
                 return false;
-            printf("%i\n", gamma_golden_move(g, args[0], args[1], args[2]));
+            fprintf(out, "%i\n",
+                    gamma_golden_move(g, args[0], args[1], args[2]));
             break;
         case 'b':
             if (numberOfArgs != 1)
                 return false;
-            printf("%lu\n", gamma_busy_fields(g, args[0]));
+            fprintf(out, "%lu\n", gamma_busy_fields(g, args[0]));
             break;
         case 'f':
             if (numberOfArgs != 1)
                 return false;
-            printf("%lu\n", gamma_free_fields(g, args[0]));
+            fprintf(out, "%lu\n", gamma_free_fields(g, args[0]));
             break;
         case 'q':
             if (numberOfArgs != 1)
                 return false;
-            printf("%i\n", gamma_golden_possible(g, args[0]));
+            fprintf(out, "%i\n", gamma_golden_possible(g, args[0]));
+            break;
+        case 'a':
+            if (numberOfArgs != 3)
+                return false;
+            fprintf(out, "%i\n",
+                    gamma_ai_move(g, args[0], args[1], args[2]));
+            break;
+        case 's':
+            if (numberOfArgs != 0)
+                return false;
+            GammaStats stats;
+            if (!gamma_stats(g, &stats))
+                return false;
+            fprintf(out, "%lu %lu %lu %lu %lu %lu\n", stats.bfs_runs,
+                    stats.cells_visited, stats.queue_pushes,
+                    stats.owner_changes, stats.trial_validations,
+                    stats.bytes_rendered);
+            break;
+        case 'r':
+            if (numberOfArgs != 1)
+                return false;
+            uint32_t count = gamma_player_areas(g, args[0], NULL, 0);
+            if (count == 0) {
+                fprintf(out, "0\n");
+                break;
+            }
+            uint32_t *areas = malloc(count * sizeof(uint32_t));
+            if (areas == NULL)
+                return false;
+            gamma_player_areas(g, args[0], areas, count);
+            fprintf(out, "%u\n", count);
+            for (uint32_t i = 0; i < count; i++) {
+                GammaArea area;
+                gamma_area(g, areas[i], &area);
+                fprintf(out, "%u %lu %u %u %u %u\n", areas[i], area.size,
+                        area.min_x, area.min_y, area.max_x, area.max_y);
+            }
+            free(areas);
             break;
+        case 'c':
+            if (numberOfArgs != 5)
+                return false;
+            return check_rectangle(g, args[0], args[1], args[2], args[3],
+                                   args[4], out);
         case 'p':
             if (numberOfArgs != 0)
                 return false;
             char *board = gamma_board(g);
-            printf("%s", board);
+            fprintf(out, "%s", board);
             free(board);
             break;
         default:
@@ -11,16 +11,38 @@
 #include "types.h"
 #include "moves.h"
 #include "gamma.h"
+#include <stdio.h>
+
+/**@brief Maximum number of arguments of a command
+ * i.e. more arguments means the input is invalid
+ */
+#define MAX_NUMBER_OF_ARGS 5
+
+/** @brief Splits a line of the input into a command and its arguments
+ * The line is split with respect to the whitespaces, the first token
+ * must be a single character and the other ones numbers
+ * fitting in uint32_t. Function replaces whitespaces in @p line with \0.
+ * @param line          - line to split, without the newline
+ * @param command       - where to save the command
+ * @param args          - array of MAX_NUMBER_OF_ARGS elements
+ *                        where to save the arguments
+ * @param numberOfArgs  - where to save the number of the arguments
+ * @return true if the line is a correct command, false otherwise
+ */
+bool parseCommand(char *line, char *command, uint32_t *args,
+                  uint32_t *numberOfArgs);
 
 /** @brief Process a batch mode command
- * Process a batch mode command and print its return value to stdout
+ * Process a batch mode command and print its return value to @p out
  * (if the command is correct)
  * @param g             - pointer to the structure storing the game state.
  * @param command       - a one-letter command
  * @param args          - array of arguments for the command
  * @param numberOfArgs  - length of @p args array
+ * @param out           - where to print
  * @return true if the command is correct, false otherwise
  */
-bool batch(gamma_t *g, char command, uint32_t *args, uint32_t numberOfArgs);
+bool batch(gamma_t *g, char command, uint32_t *args, uint32_t numberOfArgs,
+           FILE *out);
 
 #endif //BATCH_H
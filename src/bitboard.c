@@ -0,0 +1,219 @@
+/** @file
+ * Implementation of the bitboards of narrow boards
+ *
+ * The rows of all the owners are kept in a single array shared
+ * copy-on-write with the forks, the row y of the owner p has index
+ * p * height + y. The rows of the fake player store the fields
+ * with a pawn instead of the free ones, so that the array
+ * of an empty board is all zeros and costs no memory.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include "bitboard.h"
+#include "board.h"
+#include "pages.h"
+#include "scratch.h"
+#include "stats.h"
+#include "types.c"
+
+/** @brief Structure storing the state of a flood fill
+ */
+typedef struct Fill {
+    uint64_t *rows;      /**< The filled fields of each row */
+    uint32_t owner;      /**< Owner of the filled area */
+    Position blocked;    /**< Field the fill walks around,
+                              (-1, -1) if none */
+    Position goal;       /**< Field whose filling stops the fill,
+                              (-1, -1) if none */
+    uint64_t first;      /**< First row with filled fields */
+    uint64_t last;       /**< Last row with filled fields */
+    bool found;          /**< Has @p goal been filled */
+} Fill;
+
+/** @brief Returns the mask of all the columns of the board.
+ */
+static uint64_t full_row(gamma_t *g) {
+    if (g->width == BITBOARD_MAX_WIDTH)
+        return UINT64_MAX;
+    else
+        return (UINT64_C(1) << g->width) - 1;
+}
+
+/** @brief Returns the index of a row of an owner in @ref gamma_t.rows.
+ */
+static uint64_t row_index(gamma_t *g, uint32_t owner, uint64_t y) {
+    return (uint64_t) owner * g->height + y;
+}
+
+/** @brief Returns the fields of a row owned by an owner.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param owner         – zero or the index of the player
+ * @param y             – index of the row
+ * @return Mask with bit x set iff @p owner owns the field (x, @p y).
+ */
+static uint64_t owner_row(gamma_t *g, uint32_t owner, uint64_t y) {
+    uint64_t row = *(const uint64_t *) pages_read(g->rows,
+                                                  row_index(g, owner, y));
+    return owner == 0 ? full_row(g) & ~row : row;
+}
+
+bool bitboard_new(gamma_t *g) {
+    g->rows = NULL;
+    // Checking the players first keeps the product from overflowing
+    if (g->width > BITBOARD_MAX_WIDTH ||
+        g->number_of_players >= BITBOARD_MAX_ROWS ||
+        ((uint64_t) g->number_of_players + 1) * g->height > BITBOARD_MAX_ROWS)
+        return true;
+
+    g->rows = pages_new(((uint64_t) g->number_of_players + 1) * g->height,
+                        sizeof(uint64_t), NULL, NULL);
+    return g->rows != NULL;
+}
+
+bool bitboard_prepare(gamma_t *g, uint64_t slot, uint32_t owner) {
+    if (g->rows == NULL)
+        return true;
+
+    Position position = slot_position(g, slot);
+    return pages_write(g->rows, row_index(g, owner, position.y)) != NULL;
+}
+
+void bitboard_set(gamma_t *g, uint64_t slot, uint32_t old_owner,
+                  uint32_t new_owner) {
+    if (g->rows == NULL)
+        return;
+
+    // The row of the fake player has the bit of each taken field set,
+    // so it's flipped like the row of the other owner
+    Position position = slot_position(g, slot);
+    uint64_t bit = UINT64_C(1) << position.x;
+    *(uint64_t *) pages_write(g->rows,
+                              row_index(g, old_owner, position.y)) ^= bit;
+    *(uint64_t *) pages_write(g->rows,
+                              row_index(g, new_owner, position.y)) ^= bit;
+}
+
+/** @brief Extends the fields of @p seeds to the runs of @p own containing them.
+ *
+ * Fills towards both ends of the row at once, doubling the distance
+ * at each step, so a whole row takes six steps.
+ * @param seeds         – fields to start from, only the ones in @p own count
+ * @param own           – fields the fill may enter
+ * @return The fields of @p own reachable from @p seeds within the row.
+ */
+static uint64_t row_fill(uint64_t seeds, uint64_t own) {
+    uint64_t up = seeds & own, down = up;
+    uint64_t up_own = own, down_own = own;
+    for (int shift = 1; shift < BITBOARD_MAX_WIDTH; shift *= 2) {
+        up |= up_own & (up << shift);
+        up_own &= up_own << shift;
+        down |= down_own & (down >> shift);
+        down_own &= down_own >> shift;
+    }
+    return up | down;
+}
+
+/** @brief Returns the fields of a row the fill may enter.
+ */
+static uint64_t fillable_row(gamma_t *g, Fill *fill, uint64_t y) {
+    uint64_t result = owner_row(g, fill->owner, y);
+    if ((int64_t) y == fill->blocked.y)
+        result &= ~(UINT64_C(1) << fill->blocked.x);
+    return result;
+}
+
+/** @brief Fills the fields of a row reachable from its filled neighbours.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param fill          – the state of the fill
+ * @param y             – index of the row
+ * @return True if any field of the row has been filled, false otherwise.
+ */
+static bool grow_row(gamma_t *g, Fill *fill, uint64_t y) {
+    uint64_t *rows = fill->rows;
+    uint64_t seeds = rows[y];
+    if (y > 0)
+        seeds |= rows[y - 1];
+    if (y + 1 < g->height)
+        seeds |= rows[y + 1];
+    if (seeds == rows[y])
+        return false;
+
+    uint64_t grown = row_fill(seeds, fillable_row(g, fill, y));
+    if (grown == rows[y])
+        return false;
+
+    rows[y] = grown;
+    if (fill->first > y)
+        fill->first = y;
+    if (fill->last < y)
+        fill->last = y;
+    if ((int64_t) y == fill->goal.y && ((grown >> fill->goal.x) & 1))
+        fill->found = true;
+    return true;
+}
+
+bool bitboard_fill(gamma_t *g, uint64_t source, uint64_t goal,
+                   uint64_t blocked, uint64_t **rows, uint64_t *first,
+                   uint64_t *last, bool *found) {
+    *rows = scratch_get(SCRATCH_ROWS, g->height);
+    if (*rows == NULL)
+        return false;
+
+    Position none = {-1, -1};
+    Position start = slot_position(g, source);
+    Fill fill = {.rows = *rows, .owner = slot_owner(g, source),
+                 .blocked = blocked == NO_SLOT ? none :
+                            slot_position(g, blocked),
+                 .goal = goal == NO_SLOT ? none : slot_position(g, goal),
+                 .first = start.y, .last = start.y, .found = false};
+    STATS_ADD(g, bfs_runs, 1);
+
+    // The source row is grown from a seed of its own,
+    // the other ones from their neighbours
+    fill.rows[start.y] = row_fill(UINT64_C(1) << start.x,
+                                  fillable_row(g, &fill, start.y));
+    fill.found = (int64_t) start.y == fill.goal.y &&
+                 ((fill.rows[start.y] >> fill.goal.x) & 1);
+
+    // Sweep up and down until nothing changes
+    bool changed = true;
+    while (changed && !fill.found) {
+        changed = false;
+        for (uint64_t y = fill.first;
+             y <= fill.last + 1 && y < g->height && !fill.found; y++)
+            changed |= grow_row(g, &fill, y);
+        for (uint64_t y = fill.last + 1;
+             y-- > 0 && y + 1 >= fill.first && !fill.found;)
+            changed |= grow_row(g, &fill, y);
+    }
+
+    for (uint64_t y = fill.first; y <= fill.last; y++)
+        STATS_ADD(g, cells_visited, __builtin_popcountll(fill.rows[y]));
+
+    *first = fill.first;
+    *last = fill.last;
+    *found = fill.found;
+    return true;
+}
+
+void bitboard_clear(uint64_t *rows, uint64_t first, uint64_t last) {
+    for (uint64_t y = first; y <= last; y++)
+        rows[y] = 0;
+}
+
+uint64_t bitboard_next(gamma_t *g, uint32_t owner, uint64_t cell) {
+    if (g->rows == NULL)
+        return cell;
+
+    uint64_t y = cell / g->width;
+    uint64_t x = cell % g->width;
+    for (; y < g->height; y++, x = 0) {
+        uint64_t row = owner_row(g, owner, y) >> x;
+        if (row != 0)
+            return y * g->width + x + __builtin_ctzll(row);
+    }
+    return (uint64_t) g->width * g->height;
+}
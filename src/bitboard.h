@@ -0,0 +1,113 @@
+/** @file
+ * Interface of the bitboards of narrow boards
+ *
+ * On a board at most @ref BITBOARD_MAX_WIDTH columns wide a row
+ * of the fields of an owner fits in a single word: bit x of the row y
+ * of an owner is set iff he owns the field (x, y). An area is then
+ * flood filled a whole row at a time, with a few shifts, ANDs and ORs
+ * per row, instead of field by field.
+ *
+ * The bitboards are created by @ref gamma_new for narrow boards,
+ * unless there are too many rows of all the owners together,
+ * and updated by @ref set_owner. The searches of board.c use them
+ * whenever @ref gamma_t.rows is not NULL.
+ *
+ * Implementation:
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+/** @brief Largest width of a board with bitboards, bits of a word
+ */
+#define BITBOARD_MAX_WIDTH 64
+
+/** @brief Largest number of rows of all the owners together
+ *
+ * Limits the page table of @ref gamma_t.rows.
+ */
+#define BITBOARD_MAX_ROWS (UINT64_C(1) << 24)
+
+/** @brief Creates the bitboards of a new game.
+ *
+ * Sets @ref gamma_t.rows to the bitboards of an empty board
+ * or to NULL if the board is too wide or there are too many rows.
+ * @ref gamma_t.width, @ref gamma_t.height and
+ * @ref gamma_t.number_of_players must be set.
+ * @param g             – pointer to the structure storing the game state
+ * @return False if the allocation has failed, true otherwise.
+ *         @ref gamma_t.rows is NULL or must be freed in both cases.
+ */
+bool bitboard_new(gamma_t *g);
+
+/** @brief Makes sure @ref bitboard_set won't fail for an owner.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @param owner         – zero or the index of the player
+ * @return False if the allocation has failed, true otherwise.
+ */
+bool bitboard_prepare(gamma_t *g, uint64_t slot, uint32_t owner);
+
+/** @brief Moves a field from the bitboard of one owner to another.
+ *
+ * Does nothing if the game has no bitboards.
+ * The rows of both owners must have been prepared
+ * with @ref bitboard_prepare.
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @param old_owner     – zero or the index of the player owning the field
+ * @param new_owner     – zero or the index of the player,
+ *                        different from @p old_owner
+ */
+void bitboard_set(gamma_t *g, uint64_t slot, uint32_t old_owner,
+                  uint32_t new_owner);
+
+/** @brief Flood fills an area row by row.
+ *
+ * Fills the area containing the field in slot @p source,
+ * walking around the field in slot @p blocked as if it had
+ * another owner, until the whole area or the field in slot @p goal
+ * is filled. The filled fields are left in a scratch array
+ * of the current thread (see @ref scratch.h), in the rows
+ * from @p first to @p last, which must be cleared
+ * with @ref bitboard_clear. The game must have bitboards.
+ * @param g             – pointer to the structure storing the game state
+ * @param source        – slot of a field inside the board
+ * @param goal          – slot of a field inside the board or @ref NO_SLOT
+ * @param blocked       – slot of a field inside the board or @ref NO_SLOT
+ * @param rows          – where to store the array, bit x of its element y
+ *                        is set iff the field (x, y) has been filled
+ * @param first         – where to store the first filled row
+ * @param last          – where to store the last filled row
+ * @param found         – where to store whether @p goal was filled
+ * @return False if the allocation has failed
+ *         (in which case nothing is filled), true otherwise.
+ */
+bool bitboard_fill(gamma_t *g, uint64_t source, uint64_t goal,
+                   uint64_t blocked, uint64_t **rows, uint64_t *first,
+                   uint64_t *last, bool *found);
+
+/** @brief Clears the rows filled by @ref bitboard_fill.
+ */
+void bitboard_clear(uint64_t *rows, uint64_t first, uint64_t last);
+
+/** @brief Finds the next field of an owner.
+ *
+ * Skips the fields of the other owners a whole row at a time.
+ * @param g             – pointer to the structure storing the game state
+ * @param owner         – zero or the index of the player
+ * @param cell          – index of the field to start from
+ *                        (see @ref cell_index)
+ * @return The smallest index not smaller than @p cell of a field
+ *         of @p owner, width * height if there is none.
+ *         @p cell if the game has no bitboards.
+ */
+uint64_t bitboard_next(gamma_t *g, uint32_t owner, uint64_t cell);
+
+#endif //BITBOARD_H
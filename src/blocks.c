@@ -0,0 +1,574 @@
+/** @file
+ * Implementation of the block-level connectivity index
+ *
+ * The blocks are kept in an array of pointers shared copy-on-write
+ * with the forks, a block is shared by the games whose pages
+ * point at it and copied before any of them modifies it.
+ *
+ * A search is a breadth-first search over the components
+ * of the blocks. A component is identified by the index of its block
+ * times @ref BLOCK_FIELDS plus its label minus one. Expanding
+ * a component scans the edges of its block for the fields
+ * of the player, see @ref cross_edge.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "blocks.h"
+#include "board.h"
+#include "pages.h"
+#include "queue.h"
+#include "scratch.h"
+#include "stats.h"
+#include "types.c"
+
+/** @brief Structure storing the components of a single block
+ */
+typedef struct BlockData {
+    atomic_uint_fast64_t refcount;  /**< Number of the page table entries
+                                         pointing to this block,
+                                         possibly in different threads */
+    uint16_t last_label;            /**< Largest label given since
+                                         the block was last labelled */
+    uint16_t labels[BLOCK_FIELDS];  /**< Component of each field,
+                                         row by row, from 1, zero for
+                                         the free fields and outside
+                                         the board */
+} *Block;
+
+/** @brief Structure storing the state of a search
+ */
+typedef struct Search {
+    gamma_t *g;              /**< The game searched */
+    uint32_t owner;          /**< Player owning the searched area */
+    uint64_t blocked_block;  /**< Index of the block of the field
+                                  the search walks around,
+                                  UINT64_MAX if none */
+    uint16_t scratch[BLOCK_FIELDS]; /**< Components of that block
+                                         without the field */
+    uint64_t *reached_bits;  /**< Bitmap of the reached components,
+                                  see @ref scratch.h */
+    uint64_t goal;           /**< Component searched for */
+    Queue queue;             /**< Components to expand */
+    Slots reached;           /**< Components marked by the search */
+    bool found;              /**< Has @p goal been reached */
+} Search;
+
+/** @brief Returns the number of the columns of blocks.
+ */
+static uint64_t blocks_wide(gamma_t *g) {
+    return ((uint64_t) g->width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+/** @brief Returns the number of the blocks of the board.
+ */
+static uint64_t number_of_blocks(gamma_t *g) {
+    return blocks_wide(g) *
+           (((uint64_t) g->height + BLOCK_SIZE - 1) / BLOCK_SIZE);
+}
+
+/** @brief Returns the index of the block of a field.
+ */
+static uint64_t block_index(gamma_t *g, Position position) {
+    return (uint64_t) (position.y / BLOCK_SIZE) * blocks_wide(g) +
+           position.x / BLOCK_SIZE;
+}
+
+/** @brief Returns the index of a field within its block.
+ */
+static uint32_t local_index(Position position) {
+    return (position.y % BLOCK_SIZE) * BLOCK_SIZE + position.x % BLOCK_SIZE;
+}
+
+/** @brief Returns the position of the first field of a block.
+ */
+static Position block_origin(gamma_t *g, uint64_t index) {
+    Position result = {index % blocks_wide(g) * BLOCK_SIZE,
+                       index / blocks_wide(g) * BLOCK_SIZE};
+    return result;
+}
+
+/** @brief Returns the size of a block cut by the edge of the board.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param origin        – the position of the first field of the block
+ * @return Number of the columns (x) and of the rows (y) of the block.
+ */
+static Position block_size(gamma_t *g, Position origin) {
+    Position result = {g->width - origin.x, g->height - origin.y};
+    if (result.x > BLOCK_SIZE)
+        result.x = BLOCK_SIZE;
+    if (result.y > BLOCK_SIZE)
+        result.y = BLOCK_SIZE;
+    return result;
+}
+
+/** @brief Lists the neighbours of a field lying in its block.
+ *
+ * @param field         – index of the field within the block
+ * @param size          – the size of the block, see @ref block_size
+ * @param neighbours    – array of 4 elements where the indices
+ *                        of the neighbours within the block are saved
+ * @param directions    – array of 4 elements where the indices
+ *                        of their directions in
+ *                        @ref gamma_t.neighbour_offsets are saved
+ * @return Number of the neighbours.
+ */
+static uint32_t block_neighbours(uint32_t field, Position size,
+                                 uint32_t *neighbours, int *directions) {
+    uint32_t x = field % BLOCK_SIZE, y = field / BLOCK_SIZE;
+    uint32_t result = 0;
+    // East, north, west and south
+    if (x + 1 < size.x) {
+        directions[result] = 0;
+        neighbours[result++] = field + 1;
+    }
+    if (y + 1 < size.y) {
+        directions[result] = 1;
+        neighbours[result++] = field + BLOCK_SIZE;
+    }
+    if (x > 0) {
+        directions[result] = 2;
+        neighbours[result++] = field - 1;
+    }
+    if (y > 0) {
+        directions[result] = 3;
+        neighbours[result++] = field - BLOCK_SIZE;
+    }
+    return result;
+}
+
+/** @brief Labels the components of the fields of a block.
+ *
+ * Two neighbouring fields lie in the same component
+ * iff they have the same nonzero key.
+ * @param keys          – key of each field of the block
+ * @param size          – the size of the block, see @ref block_size
+ * @param skipped       – index of a field left without a label
+ *                        or @ref BLOCK_FIELDS
+ * @param labels        – where to store the labels
+ * @return The number of the labels.
+ */
+static uint16_t label_fields(const uint32_t *keys, Position size,
+                             uint32_t skipped, uint16_t *labels) {
+    memset(labels, 0, BLOCK_FIELDS * sizeof(uint16_t));
+    uint16_t stack[BLOCK_FIELDS];
+    uint16_t result = 0;
+
+    for (uint32_t y = 0; y < size.y; y++) {
+        for (uint32_t x = 0; x < size.x; x++) {
+            uint32_t start = y * BLOCK_SIZE + x;
+            if (keys[start] == 0 || labels[start] != 0 || start == skipped)
+                continue;
+
+            // Each field is pushed once, when it gets its label
+            uint32_t count = 0;
+            labels[start] = ++result;
+            stack[count++] = start;
+            while (count > 0) {
+                uint32_t field = stack[--count];
+                uint32_t neighbours[4];
+                int directions[4];
+                uint32_t number = block_neighbours(field, size, neighbours,
+                                                   directions);
+                for (uint32_t i = 0; i < number; i++) {
+                    uint32_t next = neighbours[i];
+                    if (labels[next] == 0 && next != skipped &&
+                        keys[next] == keys[field]) {
+                        labels[next] = result;
+                        stack[count++] = next;
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/** @brief Labels a block again from the owners of its fields.
+ */
+static void relabel(gamma_t *g, uint64_t index, Block block) {
+    Position origin = block_origin(g, index);
+    Position size = block_size(g, origin);
+    uint64_t origin_slot = field_slot(g, origin);
+
+    uint32_t owners[BLOCK_FIELDS];
+    for (uint32_t y = 0; y < size.y; y++)
+        for (uint32_t x = 0; x < size.x; x++)
+            owners[y * BLOCK_SIZE + x] =
+                    slot_owner(g, origin_slot + y * g->stride + x);
+    STATS_ADD(g, cells_visited, size.x * size.y);
+
+    block->last_label = label_fields(owners, size, BLOCK_FIELDS,
+                                     block->labels);
+}
+
+/** @brief Drops one reference to a block, freeing it
+ * if it was the last one.
+ */
+static void block_release(Block block) {
+    if (block != NULL &&
+        atomic_fetch_sub_explicit(&block->refcount, 1,
+                                  memory_order_acq_rel) == 1)
+        free(block);
+}
+
+/** @brief Takes a reference to a copied block.
+ *
+ * Called by @ref pages_write for each entry of a duplicated page.
+ * @param entry         – pointer to the copied pointer to the block
+ */
+static void block_copied(void *entry) {
+    Block block = *(Block *) entry;
+    if (block != NULL)
+        atomic_fetch_add_explicit(&block->refcount, 1, memory_order_relaxed);
+}
+
+/** @brief Releases a block.
+ *
+ * Called by @ref pages_delete for each entry of a freed page.
+ * @param entry         – pointer to the freed pointer to the block
+ */
+static void block_freed(void *entry) {
+    block_release(*(Block *) entry);
+}
+
+bool blocks_new(gamma_t *g) {
+    g->blocks = NULL;
+    if (g->rows != NULL)
+        return true;
+
+    // The blocks of an empty board are not allocated
+    g->blocks = pages_new(number_of_blocks(g), sizeof(Block),
+                          block_copied, block_freed);
+    return g->blocks != NULL;
+}
+
+bool blocks_prepare(gamma_t *g, uint64_t slot) {
+    if (g->blocks == NULL)
+        return true;
+
+    Block *entry = pages_write(g->blocks,
+                               block_index(g, slot_position(g, slot)));
+    if (entry == NULL)
+        return false;
+
+    if (*entry != NULL &&
+        atomic_load_explicit(&(*entry)->refcount,
+                             memory_order_acquire) == 1)
+        return true;
+
+    // A block without any pawn has no labels yet
+    Block copy = calloc(1, sizeof(struct BlockData));
+    if (copy == NULL)
+        return false;
+
+    atomic_init(&copy->refcount, 1);
+    if (*entry != NULL) {
+        copy->last_label = (*entry)->last_label;
+        memcpy(copy->labels, (*entry)->labels, sizeof(copy->labels));
+        block_release(*entry);
+    }
+    *entry = copy;
+    return true;
+}
+
+/** @brief Splits the component of a field losing its pawn.
+ *
+ * Gives each part of the component a new label.
+ * @param g             – pointer to the structure storing the game state
+ * @param index         – index of the block
+ * @param block         – the block, not shared
+ * @param field         – index of the field within the block
+ * @param size          – the size of the block, see @ref block_size
+ * @return True if the labels have run out and the whole block
+ *         has been labelled again from the board, false otherwise.
+ */
+static bool remove_field(gamma_t *g, uint64_t index, Block block,
+                         uint32_t field, Position size) {
+    uint16_t label = block->labels[field];
+    block->labels[field] = 0;
+
+    uint32_t neighbours[4];
+    int directions[4];
+    uint32_t number = block_neighbours(field, size, neighbours, directions);
+    uint16_t stack[BLOCK_FIELDS];
+
+    // Every field of the component is connected to one of the neighbours
+    for (uint32_t i = 0; i < number; i++) {
+        if (block->labels[neighbours[i]] != label)
+            continue;
+        if (block->last_label == BLOCK_FIELDS) {
+            relabel(g, index, block);
+            return true;
+        }
+
+        uint16_t part = ++block->last_label;
+        uint32_t count = 0;
+        block->labels[neighbours[i]] = part;
+        stack[count++] = neighbours[i];
+        while (count > 0) {
+            uint32_t current = stack[--count];
+            uint32_t next[4];
+            uint32_t next_number = block_neighbours(current, size, next,
+                                                    directions);
+            for (uint32_t j = 0; j < next_number; j++) {
+                if (block->labels[next[j]] == label) {
+                    block->labels[next[j]] = part;
+                    stack[count++] = next[j];
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/** @brief Joins the components of the neighbours of a field
+ * receiving a pawn.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of the field
+ * @param index         – index of the block
+ * @param block         – the block, not shared
+ * @param owner         – the player owning the field
+ */
+static void add_field(gamma_t *g, uint64_t slot, uint64_t index, Block block,
+                      uint32_t owner) {
+    uint32_t field = local_index(slot_position(g, slot));
+    uint32_t neighbours[4];
+    int directions[4];
+    uint32_t number = block_neighbours(field,
+                                       block_size(g, block_origin(g, index)),
+                                       neighbours, directions);
+
+    uint16_t joined[4];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < number; i++) {
+        uint64_t neighbour = slot + g->neighbour_offsets[directions[i]];
+        uint16_t label = block->labels[neighbours[i]];
+        bool is_new = slot_owner(g, neighbour) == owner;
+        for (uint32_t j = 0; j < count && is_new; j++)
+            if (joined[j] == label)
+                is_new = false;
+        if (is_new)
+            joined[count++] = label;
+    }
+
+    if (count == 0) {
+        // The labels have run out, relabelling leaves at most
+        // as many as there are components
+        if (block->last_label == BLOCK_FIELDS)
+            relabel(g, index, block);
+        else
+            block->labels[field] = ++block->last_label;
+        return;
+    }
+
+    block->labels[field] = joined[0];
+    for (uint32_t i = 0; i < BLOCK_FIELDS && count > 1; i++)
+        for (uint32_t j = 1; j < count; j++)
+            if (block->labels[i] == joined[j])
+                block->labels[i] = joined[0];
+}
+
+void blocks_set(gamma_t *g, uint64_t slot, uint32_t old_owner,
+                uint32_t new_owner) {
+    if (g->blocks == NULL)
+        return;
+
+    Position position = slot_position(g, slot);
+    uint64_t index = block_index(g, position);
+    Block block = *(Block *) pages_write(g->blocks, index);
+
+    if (old_owner != 0 &&
+        remove_field(g, index, block, local_index(position),
+                     block_size(g, block_origin(g, index))))
+        return;
+    if (new_owner != 0)
+        add_field(g, slot, index, block, new_owner);
+}
+
+/** @brief Returns the labels of a block.
+ *
+ * @param search        – the state of the search
+ * @param index         – index of the block, which must have a pawn
+ */
+static const uint16_t *get_labels(Search *search, uint64_t index) {
+    if (index == search->blocked_block)
+        return search->scratch;
+    return (*(const Block *) pages_read(search->g->blocks, index))->labels;
+}
+
+/** @brief Marks a component and queues it if it has not been reached yet.
+ *
+ * @param search        – the state of the search
+ * @param index         – index of the block
+ * @param label         – label of the component
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool reach(Search *search, uint64_t index, uint16_t label) {
+    uint64_t *reached = search->reached_bits;
+    uint64_t component = index * BLOCK_FIELDS + label - 1;
+    if ((reached[component / 64] >> (component % 64)) & 1)
+        return true;
+
+    // A component is marked only once it's stored,
+    // so that all the marked ones can be unmarked
+    if (!slots_append(&search->reached, component))
+        return false;
+    reached[component / 64] |= UINT64_C(1) << (component % 64);
+    search->found |= component == search->goal;
+    return queue_insert(search->queue, component);
+}
+
+/** @brief Reaches the components behind an edge of a block.
+ *
+ * Walks along the fields of the edge, from @p first every @p step,
+ * and reaches the component of the neighbour of each field
+ * of the component @p label across the edge,
+ * if it belongs to the player of the search.
+ * @param search        – the state of the search
+ * @param index         – index of the block
+ * @param label         – label of the component being expanded
+ * @param first         – index within the block of the first field
+ *                        of the edge
+ * @param step          – difference between the indices within the block
+ *                        of the consecutive fields of the edge
+ * @param count         – number of the fields of the edge
+ * @param neighbour     – index of the block behind the edge
+ * @param jump          – difference between the index within its block
+ *                        of the neighbour of a field and the index
+ *                        of the field
+ * @param offset        – difference between the slot of the neighbour
+ *                        of a field and the slot of the field
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool cross_edge(Search *search, uint64_t index, uint16_t label,
+                       uint32_t first, uint32_t step, uint32_t count,
+                       uint64_t neighbour, int32_t jump, int64_t offset) {
+    gamma_t *g = search->g;
+    const uint16_t *labels = get_labels(search, index);
+    uint64_t origin_slot = field_slot(g, block_origin(g, index));
+
+    for (uint32_t i = 0, field = first; i < count && !search->found;
+         i++, field += step) {
+        if (labels[field] != label)
+            continue;
+
+        uint64_t slot = origin_slot + field / BLOCK_SIZE * g->stride +
+                        field % BLOCK_SIZE;
+        if (slot_owner(g, slot + offset) != search->owner)
+            continue;
+
+        // The field walked around has no label
+        uint16_t next = get_labels(search, neighbour)[field + jump];
+        if (next != 0 && !reach(search, neighbour, next))
+            return false;
+    }
+    return true;
+}
+
+/** @brief Reaches the components behind the edges of a component.
+ *
+ * @param search        – the state of the search
+ * @param component     – the component to expand
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool expand(Search *search, uint64_t component) {
+    gamma_t *g = search->g;
+    uint64_t index = component / BLOCK_FIELDS;
+    uint16_t label = component % BLOCK_FIELDS + 1;
+    uint64_t wide = blocks_wide(g);
+    Position origin = block_origin(g, index);
+    Position size = block_size(g, origin);
+    uint32_t last_column = size.x - 1, last_row = size.y - 1;
+
+    // East, north, west and south, as in gamma_t.neighbour_offsets
+    return (origin.x + size.x >= g->width ||
+            cross_edge(search, index, label, last_column, BLOCK_SIZE, size.y,
+                       index + 1, -(int32_t) last_column,
+                       g->neighbour_offsets[0])) &&
+           (origin.y + size.y >= g->height ||
+            cross_edge(search, index, label, last_row * BLOCK_SIZE, 1, size.x,
+                       index + wide, -(int32_t) (last_row * BLOCK_SIZE),
+                       g->neighbour_offsets[1])) &&
+           (origin.x == 0 ||
+            cross_edge(search, index, label, 0, BLOCK_SIZE, size.y,
+                       index - 1, BLOCK_SIZE - 1,
+                       g->neighbour_offsets[2])) &&
+           (origin.y == 0 ||
+            cross_edge(search, index, label, 0, 1, size.x, index - wide,
+                       (BLOCK_SIZE - 1) * BLOCK_SIZE,
+                       g->neighbour_offsets[3]));
+}
+
+/** @brief Labels the block of the field the search walks around.
+ *
+ * Splits the components of the block, which only lose the field.
+ */
+static void label_scratch(Search *search, uint64_t blocked) {
+    gamma_t *g = search->g;
+    Position position = slot_position(g, blocked);
+    uint64_t index = block_index(g, position);
+    Position size = block_size(g, block_origin(g, index));
+    Block block = *(const Block *) pages_read(g->blocks, index);
+    // A free field does not split anything
+    if (block == NULL)
+        return;
+
+    uint32_t keys[BLOCK_FIELDS];
+    for (uint32_t i = 0; i < BLOCK_FIELDS; i++)
+        keys[i] = block->labels[i];
+    label_fields(keys, size, local_index(position), search->scratch);
+    search->blocked_block = index;
+}
+
+/** @brief Returns the component of a field.
+ */
+static uint64_t component_of(Search *search, uint64_t slot) {
+    Position position = slot_position(search->g, slot);
+    uint64_t index = block_index(search->g, position);
+    return index * BLOCK_FIELDS +
+           get_labels(search, index)[local_index(position)] - 1;
+}
+
+bool blocks_connected(gamma_t *g, uint64_t a, uint64_t b, uint64_t blocked,
+                      bool *result) {
+    Search search = {.g = g, .owner = slot_owner(g, a),
+                     .blocked_block = UINT64_MAX,
+                     .reached_bits = scratch_get(SCRATCH_REACHED,
+                                                 number_of_blocks(g) *
+                                                 BLOCK_FIELDS / 64)};
+    if (search.reached_bits == NULL)
+        return false;
+    if (blocked != NO_SLOT)
+        label_scratch(&search, blocked);
+    STATS_ADD(g, bfs_runs, 1);
+
+    uint64_t start = component_of(&search, a);
+    search.goal = component_of(&search, b);
+    search.queue = queue_new(number_of_blocks(g) * BLOCK_FIELDS - 1);
+
+    bool succeeded = search.queue != NULL &&
+                     reach(&search, start / BLOCK_FIELDS,
+                           start % BLOCK_FIELDS + 1);
+    while (succeeded && !search.found && !queue_empty(search.queue))
+        succeeded = expand(&search, queue_pop(search.queue));
+
+    for (uint64_t i = 0; i < search.reached.count; i++) {
+        uint64_t component = search.reached.slots[i];
+        search.reached_bits[component / 64] &=
+                ~(UINT64_C(1) << (component % 64));
+    }
+
+    if (search.queue != NULL) {
+        STATS_ADD(g, queue_pushes, queue_pushes(search.queue));
+        queue_delete(search.queue);
+    }
+    slots_free(&search.reached);
+    *result = search.found;
+    return succeeded;
+}
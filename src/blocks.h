@@ -0,0 +1,99 @@
+/** @file
+ * Interface of the block-level connectivity index
+ *
+ * Boards without bitboards (see @ref bitboard.h) are cut into blocks
+ * of @ref BLOCK_SIZE x @ref BLOCK_SIZE fields. Each block stores
+ * the components the fields of the players form within the block:
+ * two fields of a player have the same label iff one can get
+ * from one to the other without leaving the block. Two fields
+ * of a player lie in the same area iff one can get from the component
+ * of one to the component of the other crossing the edges
+ * of the blocks between fields of the player.
+ *
+ * A search then walks the components instead of the fields.
+ * Walking around a field only needs the components of its own block
+ * to be relabelled, the other blocks are used as they are.
+ *
+ * The links between the components of neighbouring blocks are not
+ * stored, each search finds them anew: a query costs reading up to
+ * 4 * @ref BLOCK_SIZE fields on the edges of the block of every
+ * component it reaches, plus relabelling the @ref BLOCK_FIELDS fields
+ * of one block when walking around a field. The reached components
+ * are marked in a bitmap with one bit per field of the board, kept
+ * by each thread between the searches (see @ref scratch.h).
+ *
+ * The blocks are updated with each change of an owner: a pawn placed
+ * on a field joins the components of its neighbours, a pawn lost
+ * to a golden move splits its component within the block.
+ * Blocks without any pawn are not allocated.
+ *
+ * Implementation:
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef BLOCKS_H
+#define BLOCKS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+/** @brief Number of the columns and of the rows of a block
+ */
+#define BLOCK_SIZE 32
+
+/** @brief Number of the fields of a block
+ */
+#define BLOCK_FIELDS (BLOCK_SIZE * BLOCK_SIZE)
+
+/** @brief Creates the blocks of a new game.
+ *
+ * Sets @ref gamma_t.blocks to the blocks of an empty board
+ * or to NULL if the game has bitboards.
+ * @ref gamma_t.rows must be set.
+ * @param g             – pointer to the structure storing the game state
+ * @return False if the allocation has failed, true otherwise.
+ *         @ref gamma_t.blocks is NULL or must be freed in both cases.
+ */
+bool blocks_new(gamma_t *g);
+
+/** @brief Makes sure @ref blocks_set won't fail for a field.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @return False if the allocation has failed, true otherwise.
+ */
+bool blocks_prepare(gamma_t *g, uint64_t slot);
+
+/** @brief Updates the components of the block of a field.
+ *
+ * Does nothing if the game has no blocks. Must be called
+ * after the owner of the field has been changed, the block
+ * must have been prepared with @ref blocks_prepare.
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @param old_owner     – zero or the index of the player owning the field
+ * @param new_owner     – zero or the index of the player,
+ *                        different from @p old_owner
+ */
+void blocks_set(gamma_t *g, uint64_t slot, uint32_t old_owner,
+                uint32_t new_owner);
+
+/** @brief Checks if two fields of a player lie in the same area
+ * without passing through a third one.
+ *
+ * The game must have blocks.
+ * @param g             – pointer to the structure storing the game state
+ * @param a             – slot of a field of a player
+ * @param b             – slot of a field of the same player
+ * @param blocked       – slot of a field inside the board or @ref NO_SLOT
+ * @param[out] result   – where to store whether one can get from @p a
+ *                        to @p b using only the fields of the player
+ *                        other than @p blocked
+ * @return False if the allocation has failed
+ *         (in which case @p result is not set), true otherwise.
+ */
+bool blocks_connected(gamma_t *g, uint64_t a, uint64_t b, uint64_t blocked,
+                      bool *result);
+
+#endif //BLOCKS_H
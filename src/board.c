@@ -8,18 +8,17 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "types.c"
+#include "board.h"
 #include "queue.h"
-
-
-/** @brief Checks if positions are the same
- *
- * @return True if @p a and @p b correspond to the same point on the board
- *         and false otherwise.
- */
-static bool positions_equal(Position a, Position b) {
-    return a.x == b.x && a.y == b.y;
-}
+#include "frontier.h"
+#include "pages.h"
+#include "stats.h"
+#include "trace.h"
+#include "bitboard.h"
+#include "blocks.h"
+#include "scratch.h"
 
 /** @brief Checks if a position lies inside the board.
  *
@@ -31,158 +30,644 @@ static bool inside_board(gamma_t *g, Position position) {
            position.y >= 0 && position.y < g->height;
 }
 
-Field get_field(gamma_t *g, Position position) {
-    if (inside_board(g, position))
-        return &g->board[position.x][position.y];
-    else
-        return NULL;
+/** @brief Defines the functions accessing @p bits bit owners.
+ *
+ * Defines cell_owner_<bits>, set_cell_owner_<bits> and row_owners_<bits>,
+ * see @ref CELL_DISPATCH. They take slots (see @ref slot). The wall,
+ * stored as the largest value of the type, is read as @ref OUTSIDE_BOARD.
+ * The setter returns false if the allocation has failed.
+ */
+#define CELL_ACCESSORS(bits)                                                  \
+static uint32_t cell_owner_##bits(gamma_t *g, uint64_t cell) {               \
+    uint32_t owner = *(const uint##bits##_t *) pages_read(g->board, cell);   \
+    return owner == UINT##bits##_MAX ? OUTSIDE_BOARD : owner;                \
+}                                                                            \
+                                                                             \
+static bool set_cell_owner_##bits(gamma_t *g, uint64_t cell, uint32_t owner) {\
+    uint##bits##_t *written = pages_write(g->board, cell);                   \
+    if (written == NULL)                                                     \
+        return false;                                                        \
+    *written = owner;                                                        \
+    return true;                                                             \
+}                                                                            \
+                                                                             \
+static void row_owners_##bits(gamma_t *g, uint64_t first, uint32_t *owners) {\
+    uint32_t x = 0;                                                          \
+    while (x < g->width) {                                                   \
+        uint64_t count;                                                      \
+        const uint##bits##_t *run = pages_read_run(g->board, first + x,      \
+                                                   &count);                  \
+        if (count > g->width - x)                                            \
+            count = g->width - x;                                            \
+        for (uint64_t i = 0; i < count; i++)                                 \
+            owners[x + i] = run[i];                                          \
+        x += count;                                                          \
+    }                                                                        \
 }
 
-/** @brief An array storing all possible directions on a 2D board
+CELL_ACCESSORS(8)
+
+CELL_ACCESSORS(16)
+
+CELL_ACCESSORS(32)
+
+/** @brief Calls the variant of @p function for the owner width of @p g.
  *
- * See the source for more information.
+ * @p function is one of the functions defined by @ref CELL_ACCESSORS,
+ * without the suffix, @p g is also passed as its first argument.
  */
-static const Position directions[5] = {
-        {1,  0},  // RIGHT
-        {0,  1},  // UP
-        {-1, 0},  // LEFT
-        {0,  -1}, // DOWN
-        {0,  0}   // ITSELF
-};
+#define CELL_DISPATCH(g, function, ...)                                       \
+    ((g)->owner_bits == 8 ? function##_8((g), __VA_ARGS__) :                  \
+     (g)->owner_bits == 16 ? function##_16((g), __VA_ARGS__) :                \
+     function##_32((g), __VA_ARGS__))
 
-/** @brief Returns the i-th neighbour of a position
- *
- * If i == 0            – returns the neighbour of @p position to the EAST
- * If i == 1            – returns the neighbour of @p position to the NORTH
- * If i == 2            – returns the neighbour of @p position to the WEST
- * If i == 3            – returns the neighbour of @p position to the SOUTH
- * If i == 4            – returns @p position itself
- * @param i             – integer in range [0, 4],
- *                        tells which neighbour to return
- * @return Position of the @p i-th neighbour of @p position
- */
-static Position get_neighbour(Position position, int i) {
-    Position result = {position.x + directions[i].x,
-                       position.y + directions[i].y};
+uint32_t slot_owner(gamma_t *g, uint64_t slot) {
+    return CELL_DISPATCH(g, cell_owner, slot);
+}
+
+uint64_t field_slot(gamma_t *g, Position position) {
+    return (uint64_t) (position.y + 1) * g->stride + position.x;
+}
+
+uint64_t slot_cell(gamma_t *g, uint64_t slot) {
+    return (slot / g->stride - 1) * g->width + slot % g->stride;
+}
+
+Position slot_position(gamma_t *g, uint64_t slot) {
+    Position result = {slot % g->stride, slot / g->stride - 1};
     return result;
 }
 
-/** @brief Performs a Breadth-First Search visit on a given field
+/** @brief Checks if the field with slot @p cell is marked.
  *
- * If the field with position @p position is a valid field to visit
- * (i.e. is inside board, hasn't been visited yet, and has owner @p player)
- * mark it as visited and add all of its neighbours to the queue.
- * @param g                    – pointer to the structure storing the game state
- * @param queue                – BFS queue storing positions to be visited next
- * @param position             – position to visit
- * @param owner                – index of the owner whose fields
- *                               are the only ones this function is allowed
- *                               to visit
- * @param what_means_visited   – changes the meaning of @ref FieldData.bfs_flag,
- *                               i.e. the function perceives
- *                               a Field @p f as visited iff
- *                               @p f->bfs_flag == @p what_means_visited
+ * @param visited       – the bitmap returned by @ref get_visited
+ * @param cell          – the slot
  */
-static void bfs_visit_field(gamma_t *g, Queue queue, Position position,
-                            uint32_t owner, bool what_means_visited) {
+static bool is_marked(const uint64_t *visited, uint64_t cell) {
+    return (visited[cell / 64] >> (cell % 64)) & 1;
+}
 
-    Field field_visited = get_field(g, position);
+/** @brief Marks or unmarks the field with slot @p cell.
+ *
+ * @param visited       – the bitmap returned by @ref get_visited
+ * @param cell          – the slot
+ * @param marked        – true to mark the field, false to unmark it
+ */
+static void set_marked(uint64_t *visited, uint64_t cell, bool marked) {
+    if (marked)
+        visited[cell / 64] |= UINT64_C(1) << (cell % 64);
+    else
+        visited[cell / 64] &= ~(UINT64_C(1) << (cell % 64));
+}
 
-    if (field_visited != NULL &&
-        field_visited->owner == owner &&
-        field_visited->bfs_flag != what_means_visited) {
-        field_visited->bfs_flag = what_means_visited;
+/** @brief Returns the bitmap of the marked slots of the current thread.
+ *
+ * See @ref scratch.h.
+ * @return The bitmap, with a bit for each slot of @ref gamma_t.board,
+ *         or NULL if the allocation has failed.
+ */
+static uint64_t *get_visited(gamma_t *g) {
+    uint64_t slots = g->stride * ((uint64_t) g->height + 2);
+    return scratch_get(SCRATCH_VISITED, (slots + 63) / 64);
+}
 
-        for (int i = 0; i < 4; i++)
-            queue_insert(queue, get_neighbour(position, i));
+/** @brief Turns the slots from @p first to @p first + @p count into wall.
+ *
+ * The wall is the largest value of the owner type, i.e. all bits set.
+ * Pages entirely of wall share a single page.
+ * @param g             – pointer to the structure storing the game state
+ * @param first         – the first slot
+ * @param count         – number of the slots
+ * @param wall_page     – slot of a page entirely of wall or @p UINT64_MAX
+ *                        if there is none yet, updated by the function
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool build_wall(gamma_t *g, uint64_t first, uint64_t count,
+                       uint64_t *wall_page) {
+    size_t cell_size = g->owner_bits / 8;
+    uint64_t page_size = pages_page_size(g->board);
+    while (count > 0) {
+        uint64_t run_count = page_size;
+        if (first % page_size == 0 && count >= page_size &&
+            *wall_page != UINT64_MAX) {
+            pages_share(g->board, first, *wall_page);
+        } else {
+            unsigned char *run = pages_write_run(g->board, first, &run_count);
+            if (run == NULL)
+                return false;
+            if (run_count > count)
+                run_count = count;
+            memset(run, 0xFF, run_count * cell_size);
+            if (run_count == page_size)
+                *wall_page = first;
+        }
+        first += run_count;
+        count -= run_count;
     }
+    return true;
 }
 
-/** @brief Tries to find a path from @p source to @p goal by performing BFS
+bool board_new(gamma_t *g) {
+    // A power of two, so that every page of the board
+    // has the same layout of the wall, see below
+    uint64_t stride = 2;
+    while (stride < (uint64_t) g->width + 1)
+        stride *= 2;
+    uint64_t rows = (uint64_t) g->height + 2;
+    g->board = NULL;
+    if (stride > UINT64_MAX / rows)
+        return false;
+    g->stride = stride;
+
+    // The wall must be distinct from every owner, see CELL_ACCESSORS
+    size_t cell_size;
+    if (g->number_of_players < UINT8_MAX) {
+        g->owner_bits = 8;
+        cell_size = sizeof(uint8_t);
+    } else if (g->number_of_players < UINT16_MAX) {
+        g->owner_bits = 16;
+        cell_size = sizeof(uint16_t);
+    } else {
+        g->owner_bits = 32;
+        cell_size = sizeof(uint32_t);
+    }
+
+    // East, north, west, south and the field itself
+    int64_t row = (int64_t) stride;
+    int64_t offsets[5] = {1, row, -1, -row, 0};
+    for (int i = 0; i < 5; i++)
+        g->neighbour_offsets[i] = offsets[i];
+
+    g->board = pages_new(stride * rows, cell_size, NULL, NULL);
+    if (g->board == NULL)
+        return false;
+
+    // Past the bottom wall the layout repeats every period,
+    // so only the first two periods are built and the rest
+    // of the pages is shared with them, like the zero page
+    uint64_t page_size = pages_page_size(g->board);
+    uint64_t period = page_size > stride ? page_size : stride;
+    uint64_t built_rows = rows < 2 * period / stride ? rows : 2 * period / stride;
+
+    // The free fields are the zeros the pages start with
+    uint64_t wall_page = UINT64_MAX;
+    if (!build_wall(g, 0, stride, &wall_page))
+        return false;
+    for (uint64_t y = 1; y < built_rows && y < rows - 1; y++)
+        if (!build_wall(g, y * stride + g->width, stride - g->width,
+                        &wall_page))
+            return false;
+    for (uint64_t i = built_rows * stride; i < rows * stride; i += page_size)
+        pages_share(g->board, i, i - period);
+
+    return build_wall(g, (rows - 1) * stride, stride, &wall_page);
+}
+
+uint32_t get_field_owner(gamma_t *g, Position position) {
+    if (inside_board(g, position))
+        return slot_owner(g, field_slot(g, position));
+    else
+        return OUTSIDE_BOARD;
+}
+
+bool get_field_flag(gamma_t *g, Position position) {
+    uint64_t *visited = get_visited(g);
+    return visited != NULL && is_marked(visited, field_slot(g, position));
+}
+
+bool neighbours_owner(gamma_t *g, uint64_t slot, uint32_t owner) {
+    for (int i = 0; i < 4; i++)
+        if (slot_owner(g, slot + g->neighbour_offsets[i]) == owner)
+            return true;
+    return false;
+}
+
+const OwnerData *get_owner(gamma_t *g, uint32_t owner) {
+    return pages_read(g->owners, owner);
+}
+
+Owner edit_owner(gamma_t *g, uint32_t owner) {
+    return pages_write(g->owners, owner);
+}
+
+void get_row_owners(gamma_t *g, uint32_t y, uint32_t *owners) {
+    // Read the row page by page
+    Position first = {0, y};
+    CELL_DISPATCH(g, row_owners, field_slot(g, first), owners);
+}
+
+uint64_t cell_index(gamma_t *g, Position position) {
+    return (uint64_t) position.y * g->width + position.x;
+}
+
+Position cell_position(gamma_t *g, uint64_t cell) {
+    Position result = {cell % g->width, cell / g->width};
+    return result;
+}
+
+/** @brief Checks if the flood fill may enter the field in a slot.
  *
- * Tries to find a path from @p source to @p goal
- * by performing Breadth-First Search
  * @param g                    – pointer to the structure storing the game state
+ * @param visited              – the bitmap returned by @ref get_visited
+ * @param slot                 – slot inside the board or the wall
+ * @param owner                – index of the owner whose fields
+ *                               are the only ones the fill is allowed
+ *                               to enter
+ * @param blocked              – slot the fill is not allowed to enter
+ *                               or @ref NO_SLOT
+ * @param what_means_visited   – see @ref fill
+ */
+static bool fillable(gamma_t *g, const uint64_t *visited, uint64_t slot,
+                     uint32_t owner, uint64_t blocked,
+                     bool what_means_visited) {
+    return slot != blocked && slot_owner(g, slot) == owner &&
+           is_marked(visited, slot) != what_means_visited;
+}
+
+/** @brief Flood fills the area of @p source span by span.
+ *
+ * Fills whole horizontal runs of the fields of @p owner at once,
+ * walking along the row, and queues a single seed for each run
+ * touching the filled one in the rows above and below,
+ * so the queue holds runs instead of fields.
+ * The wall ends every run, so no bounds are checked.
+ * @param g                    – pointer to the structure storing the game state
+ * @param source               – slot where the fill starts
+ * @param goal                 – slot whose filling stops the fill
+ *                               or @ref NO_SLOT
  * @param owner                – index of the owner whose fields
  *                               are the only ones this function is allowed
  *                               to visit
- * @param what_means_visited   – changes the meaning of @ref FieldData.bfs_flag,
+ * @param blocked              – slot the function is not allowed to visit
+ *                               or @ref NO_SLOT
+ * @param what_means_visited   – changes the meaning of the bits
+ *                               of the bitmap of @ref get_visited,
  *                               i.e. the function perceives
- *                               a Field @p f as visited iff
- *                               @p f->bfs_flag == @p what_means_visited
+ *                               a field as visited iff its bit
+ *                               == @p what_means_visited.
+ *                               Filling with the opposite value afterwards
+ *                               makes exactly the same steps,
+ *                               so it clears the bits set by the first fill
+ * @param fields               – array to append the filled slots to
+ *                               or NULL
+ * @param found                – where to store whether @p goal was filled
+ * @return False if the allocation has failed, true otherwise.
  */
-static bool bfs(gamma_t *g, Position source, Position goal, uint32_t owner,
-                bool what_means_visited) {
+static bool fill(gamma_t *g, uint64_t source, uint64_t goal, uint32_t owner,
+                 uint64_t blocked, bool what_means_visited, Slots *fields,
+                 bool *found) {
 
-    Queue queue = queue_new();
+    *found = false;
+    uint64_t *visited = get_visited(g);
+    if (visited == NULL)
+        return false;
+
+    Queue queue = queue_new(g->stride * ((uint64_t) g->height + 2) - 1);
     if (queue == NULL)
         return false;
 
-    queue_insert(queue, source);
+    bool failed = !queue_insert(queue, source);
+    STATS_ADD(g, bfs_runs, 1);
+
+    while (!*found && !failed && !queue_empty(queue)) {
+        uint64_t seed = queue_pop(queue);
+        if (!fillable(g, visited, seed, owner, blocked, what_means_visited))
+            continue;
 
-    bool result = false;
+        uint64_t first = seed, last = seed;
+        while (fillable(g, visited, first - 1, owner, blocked,
+                        what_means_visited))
+            first--;
+        while (fillable(g, visited, last + 1, owner, blocked,
+                        what_means_visited))
+            last++;
+
+        for (uint64_t slot = first; slot <= last && !failed; slot++) {
+            // A field is marked only once it's stored,
+            // so that the caller can unmark all the marked fields
+            failed = fields != NULL && !slots_append(fields, slot);
+            if (!failed)
+                set_marked(visited, slot, what_means_visited);
+        }
+        STATS_ADD(g, cells_visited, last - first + 1);
+        *found = first <= goal && goal <= last;
 
-    while (!result && !queue_empty(queue)) {
-        Position to_visit = queue_pop(queue);
-        bfs_visit_field(g, queue, to_visit, owner, what_means_visited);
-        if (positions_equal(to_visit, goal))
-            result = true;
+        // North and south
+        for (int i = 1; i < 4 && !failed; i += 2) {
+            int64_t offset = g->neighbour_offsets[i];
+            bool in_run = false;
+            for (uint64_t slot = first; slot <= last && !failed; slot++) {
+                bool next = fillable(g, visited, slot + offset, owner,
+                                     blocked, what_means_visited);
+                if (next && !in_run)
+                    failed = !queue_insert(queue, slot + offset);
+                in_run = next;
+            }
+        }
     }
 
+    STATS_ADD(g, queue_pushes, queue_pushes(queue));
     queue_delete(queue);
-    return result;
+    return !failed;
 }
 
-bool are_in_the_same_area(gamma_t *g, Position a, Position b) {
-    uint32_t player_a = get_field(g, a)->owner;
-    uint32_t player_b = get_field(g, b)->owner;
+/** @brief Checks if fields in slots @p a and @p b lie in the same area
+ * without passing through the field in slot @p blocked.
+ *
+ * See @ref are_in_the_same_area.
+ */
+static bool connected(gamma_t *g, uint64_t a, uint64_t b, uint64_t blocked) {
+    uint32_t player_a = slot_owner(g, a);
+    uint32_t player_b = slot_owner(g, b);
 
     if (player_a == player_b) {
-        bool result = bfs(g, a, b, player_a, true);
-        bfs(g, a, b, player_a, false);
+        uint64_t start = trace_begin();
+        bool result, cleared;
+        uint64_t *rows, first, last;
+        if (g->rows != NULL) {
+            if (bitboard_fill(g, a, b, blocked, &rows, &first, &last,
+                              &result))
+                bitboard_clear(rows, first, last);
+            else
+                result = false;
+        } else if (player_a == 0 ||
+                   !blocks_connected(g, a, b, blocked, &result)) {
+            // The free fields have no blocks,
+            // nor has the search if it's out of memory
+            fill(g, a, b, player_a, blocked, true, NULL, &result);
+            fill(g, a, b, player_a, blocked, false, NULL, &cleared);
+        }
+        trace_end("are_in_the_same_area", start);
         return result;
     } else {
         return false;
     }
 }
 
+bool are_in_the_same_area(gamma_t *g, uint64_t a, uint64_t b) {
+    return connected(g, a, b, NO_SLOT);
+}
 
-uint32_t neighbouring_areas(gamma_t *g, uint32_t player,
-                            Position position, bool include_center) {
+uint32_t areas_without(gamma_t *g, uint64_t slot) {
+    uint32_t player = slot_owner(g, slot);
+    uint32_t result = 0;
 
-    if (player == 0) {
-        return 0;
-    } else {
-        uint32_t result = 0;
+    // The neighbours lie inside the board or in the wall,
+    // so they don't need to be checked
+    uint64_t neighbours[4];
+    uint32_t owners[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        neighbours[i] = slot + g->neighbour_offsets[i];
+        owners[i] = slot_owner(g, neighbours[i]);
+    }
 
-        uint32_t number_of_neighbours = 4;
-        if (include_center)
-            number_of_neighbours++;
+    for (uint32_t i = 0; i < 4 && player != 0; i++) {
+        if (owners[i] == player) {
+            bool is_new = true;
 
-        for (uint32_t i = 0; i < number_of_neighbours; i++) {
-            Position neighbour_i_position = get_neighbour(position, i);
-            Field neighbour_i = get_field(g, neighbour_i_position);
+            for (uint32_t j = 0; j < i && is_new; j++)
+                if (owners[j] == player &&
+                    connected(g, neighbours[i], neighbours[j], slot))
+                    is_new = false;
 
-            if (neighbour_i != NULL && neighbour_i->owner == player) {
-                bool is_new = true;
+            if (is_new)
+                result++;
+        }
+    }
+    return result;
+}
 
-                for (uint32_t j = 0; j < i; j++) {
-                    Position neighbour_j_position = get_neighbour(position, j);
+/** @brief Collects the fields of an area filled by @ref bitboard_fill.
+ *
+ * See @ref collect_area.
+ */
+static bool collect_rows(gamma_t *g, uint64_t start, uint64_t blocked,
+                         Slots *fields) {
+    uint64_t *visited = get_visited(g);
+    if (visited == NULL)
+        return false;
+    if (start == blocked || is_marked(visited, start))
+        return true;
 
-                    if (inside_board(g, neighbour_j_position) &&
-                        are_in_the_same_area(g,
-                                             neighbour_i_position,
-                                             neighbour_j_position)) {
+    uint64_t *rows, first, last;
+    bool found;
+    if (!bitboard_fill(g, start, NO_SLOT, blocked, &rows, &first, &last,
+                       &found))
+        return false;
 
-                        is_new = false;
-                    }
-                }
+    bool result = true;
+    for (uint64_t y = first; y <= last && result; y++) {
+        uint64_t row = rows[y];
+        Position position = {0, y};
+        uint64_t row_slot = field_slot(g, position);
+        for (; row != 0 && result; row &= row - 1) {
+            uint64_t slot = row_slot + __builtin_ctzll(row);
+            result = slots_append(fields, slot);
+            if (result)
+                set_marked(visited, slot, true);
+        }
+    }
+    bitboard_clear(rows, first, last);
+    return result;
+}
 
-                if (is_new)
-                    result++;
-            }
+bool collect_area(gamma_t *g, uint64_t start, uint64_t blocked,
+                  Slots *fields) {
+    bool found;
+    if (g->rows != NULL)
+        return collect_rows(g, start, blocked, fields);
+    else
+        return fill(g, start, NO_SLOT, slot_owner(g, start), blocked, true,
+                    fields, &found);
+}
+
+void unmark_fields(gamma_t *g, const Slots *fields) {
+    // The fields have been marked in the same bitmap,
+    // so getting it again does not allocate
+    uint64_t *visited = get_visited(g);
+    for (uint64_t i = 0; i < fields->count; i++)
+        set_marked(visited, fields->slots[i], false);
+}
+
+bool slots_append(Slots *slots, uint64_t slot) {
+    if (slots->count == slots->capacity) {
+        uint64_t capacity = slots->capacity == 0 ? 16 : 2 * slots->capacity;
+        uint64_t *bigger = realloc(slots->slots, capacity * sizeof(uint64_t));
+        if (bigger == NULL)
+            return false;
+        slots->slots = bigger;
+        slots->capacity = capacity;
+    }
+    slots->slots[slots->count++] = slot;
+    return true;
+}
+
+void slots_free(Slots *slots) {
+    free(slots->slots);
+    *slots = (Slots) {0};
+}
+
+/** @brief Maximal number of distinct owners neighbouring a single field
+ */
+#define MAX_ADJACENT_OWNERS 4
+
+/** @brief Structure storing the real players neighbouring a free field
+ */
+typedef struct Adjacency {
+    uint32_t owners[MAX_ADJACENT_OWNERS]; /**< Distinct indices of players */
+    uint32_t count;                       /**< Length of @p owners */
+} Adjacency;
+
+/** @brief Checks if @p player is one of the owners stored in @p adjacency.
+ */
+static bool adjacency_contains(Adjacency *adjacency, uint32_t player) {
+    for (uint32_t i = 0; i < adjacency->count; i++)
+        if (adjacency->owners[i] == player)
+            return true;
+    return false;
+}
+
+/** @brief Returns the players neighbouring a free field.
+ *
+ * The field in slot @p slot belongs to the frontier
+ * of exactly the players returned.
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of the field, inside the board
+ *                        or in the wall
+ * @return Distinct real players owning a neighbour of the field
+ *         or no players if the field is in the wall or is not free.
+ */
+static Adjacency adjacency(gamma_t *g, uint64_t slot) {
+    Adjacency result = {.count = 0};
+
+    if (slot_owner(g, slot) == 0) {
+        for (int i = 0; i < 4; i++) {
+            uint32_t neighbour = slot_owner(g, slot + g->neighbour_offsets[i]);
+            if (neighbour != 0 && neighbour != OUTSIDE_BOARD &&
+                !adjacency_contains(&result, neighbour))
+                result.owners[result.count++] = neighbour;
         }
-        return result;
     }
+
+    return result;
+}
+
+/** @brief Makes sure modifying the frontier of an owner won't fail.
+ *
+ * Makes the data and the frontier of @p owner private to the game,
+ * creates the frontier if the owner does not have one yet
+ * and makes room in it for the fields which may join it.
+ * @param g             – pointer to the structure storing the game state
+ * @param owner         – zero or the index of the player
+ * @param joining       – number of the fields which may join the frontier
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool prepare_owner(gamma_t *g, uint32_t owner, uint64_t joining) {
+    Owner data = edit_owner(g, owner);
+    if (data == NULL)
+        return false;
+
+    // The fake player does not have a frontier
+    if (owner == 0)
+        return true;
+    if (data->frontier == NULL)
+        data->frontier = frontier_new();
+
+    return data->frontier != NULL && frontier_unshare(&data->frontier) &&
+           frontier_reserve(data->frontier, joining);
+}
+
+/** @brief Makes sure updating the frontier of a player at a field won't fail.
+ *
+ * The frontier of @p player must have been prepared by @ref prepare_owner.
+ * A change of an owner changes the frontiers only at the field
+ * and its neighbours, at most five fields.
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – index of the player
+ * @param slot          – slot of the field
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool prepare_frontier(gamma_t *g, uint32_t player, uint64_t slot) {
+    return frontier_prepare(edit_owner(g, player)->frontier,
+                            slot_cell(g, slot), 5);
 }
 
+bool set_owner(gamma_t *g, uint64_t slot, uint32_t new_owner) {
+    // Only the field itself and its neighbours
+    // can enter or leave any frontier
+    Adjacency before[5];
+    for (int i = 0; i < 5; i++)
+        before[i] = adjacency(g, slot + g->neighbour_offsets[i]);
+
+    // Allocate everything up front, so that the game is not left
+    // half-modified. The new owner can join the frontiers with the
+    // neighbours, the owners of the neighbours only with a freed field.
+    uint32_t old_owner = slot_owner(g, slot);
+    if (!prepare_owner(g, old_owner, 0) ||
+        !prepare_owner(g, new_owner, MAX_ADJACENT_OWNERS) ||
+        !bitboard_prepare(g, slot, old_owner) ||
+        !bitboard_prepare(g, slot, new_owner) || !blocks_prepare(g, slot))
+        return false;
+
+    for (int i = 0; i < 5; i++)
+        for (uint32_t j = 0; j < before[i].count; j++)
+            if (!prepare_owner(g, before[i].owners[j], 0))
+                return false;
+
+    if (new_owner == 0) {
+        for (int i = 0; i < 4; i++) {
+            uint32_t neighbour = slot_owner(g, slot + g->neighbour_offsets[i]);
+            if (neighbour != OUTSIDE_BOARD && !prepare_owner(g, neighbour, 1))
+                return false;
+        }
+    }
+
+    // Copy the shared pages of the frontiers about to change. The players
+    // can leave the frontiers at the field and its neighbours, the new
+    // owner can join them at the free neighbours and the owners
+    // of the neighbours at a freed field.
+    for (int i = 0; i < 5; i++) {
+        uint64_t neighbour = slot + g->neighbour_offsets[i];
+        for (uint32_t j = 0; j < before[i].count; j++)
+            if (!prepare_frontier(g, before[i].owners[j], neighbour))
+                return false;
+
+        if (neighbour == slot)
+            continue;
+        uint32_t owner = slot_owner(g, neighbour);
+        if (new_owner != 0 && owner == 0 &&
+            !prepare_frontier(g, new_owner, neighbour))
+            return false;
+        if (new_owner == 0 && owner != 0 && owner != OUTSIDE_BOARD &&
+            !prepare_frontier(g, owner, slot))
+            return false;
+    }
+
+    if (!CELL_DISPATCH(g, set_cell_owner, slot, new_owner))
+        return false;
+    bitboard_set(g, slot, old_owner, new_owner);
+    blocks_set(g, slot, old_owner, new_owner);
+
+    for (int i = 0; i < 5; i++) {
+        uint64_t neighbour = slot + g->neighbour_offsets[i];
+        Adjacency after = adjacency(g, neighbour);
+
+        for (uint32_t j = 0; j < before[i].count; j++) {
+            uint32_t player = before[i].owners[j];
+            if (!adjacency_contains(&after, player))
+                frontier_remove(edit_owner(g, player)->frontier,
+                                slot_cell(g, neighbour));
+        }
+
+        for (uint32_t j = 0; j < after.count; j++) {
+            uint32_t player = after.owners[j];
+            // Cannot fail, the room has been reserved
+            // and the slots prepared above
+            if (!adjacency_contains(&before[i], player))
+                frontier_insert(edit_owner(g, player)->frontier,
+                                slot_cell(g, neighbour));
+        }
+    }
+
+    return true;
+}
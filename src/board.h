@@ -11,15 +11,159 @@
 #include "types.h"
 #include "queue.h"
 
-/** @brief Returns the field given its position.
+/** @brief Owner returned by @ref get_field_owner outside the board
  *
+ * Never an index of a player, see @ref gamma_new.
+ */
+#define OUTSIDE_BOARD UINT32_MAX
+
+/** @brief Slot which is never a slot of @ref gamma_t.board
+ */
+#define NO_SLOT UINT64_MAX
+
+/** @brief Creates the board of a new game.
+ *
+ * Sets @ref gamma_t.board to a board of free fields surrounded
+ * by a wall, and the fields of @p g describing its layout.
+ * @ref gamma_t.width, @ref gamma_t.height and
+ * @ref gamma_t.number_of_players must be set.
+ * @param g             – pointer to the structure storing the game state
+ * @return False if the allocation has failed, true otherwise.
+ *         @ref gamma_t.board is NULL or must be freed in both cases.
+ */
+bool board_new(gamma_t *g);
+
+/** @brief Returns the slot of a field in @ref gamma_t.board.
+ *
+ * The engine works on slots, positions are converted to slots
+ * at the boundary of the public interface. The board is surrounded
+ * by a wall one field thick. The fields are stored row by row
+ * in rows of @ref gamma_t.stride slots, above a row of wall,
+ * and the slots past the end of a row are wall. They are also
+ * the left wall of the next row. The neighbours of a field
+ * are then the slots at @ref gamma_t.neighbour_offsets from it.
+ * @param g             – pointer to the structure storing the game state
+ * @param position      – position lying inside the board or the wall
+ */
+uint64_t field_slot(gamma_t *g, Position position);
+
+/** @brief Returns the index of the field in a slot.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @return @ref cell_index of the field.
+ */
+uint64_t slot_cell(gamma_t *g, uint64_t slot);
+
+/** @brief Returns the position of the field in a slot.
+ *
+ * Inverse of @ref field_slot.
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ */
+Position slot_position(gamma_t *g, uint64_t slot);
+
+/** @brief Returns the owner of the field in a slot.
+ *
+ * The owner is changed by @ref set_owner.
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board or the wall
+ * @return Zero or the index of the player owning the field,
+ *         or @ref OUTSIDE_BOARD for the wall.
+ */
+uint32_t slot_owner(gamma_t *g, uint64_t slot);
+
+/** @brief Returns the owner of the field given its position.
+ *
+ * Unlike @ref slot_owner, checks the bounds.
+ * @param g             – pointer to the structure storing the game state
+ * @param position      – position of the field, possibly outside the board
+ * @return Zero or the index of the player owning the field with position
+ * @p position, or @ref OUTSIDE_BOARD if @p position is not
+ * @ref inside_board.
+ */
+uint32_t get_field_owner(gamma_t *g, Position position);
+
+/** @brief Returns the flood fill flag of the field given its position.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param position      – position lying inside the board
+ * @return True if the field with position @p position
+ *         is marked in the bitmap of the current thread
+ *         (see @ref scratch.h), false otherwise.
+ */
+bool get_field_flag(gamma_t *g, Position position);
+
+/** @brief Checks if a field neighbours one of the fields of @p owner.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param slot          – slot of a field inside the board
+ * @param owner         – zero or the index of the player
+ */
+bool neighbours_owner(gamma_t *g, uint64_t slot, uint32_t owner);
+
+/** @brief Returns the data of an owner.
+ *
+ * The data must not be modified through the returned pointer,
+ * see @ref edit_owner.
+ * @param g             – pointer to the structure storing the game state
+ * @param owner         – zero or the index of the player
+ */
+const OwnerData *get_owner(gamma_t *g, uint32_t owner);
+
+/** @brief Returns the data of an owner for modifying it.
+ *
+ * Makes sure the data is not shared with any fork of the game
+ * (see @ref gamma_fork).
+ * @param g             – pointer to the structure storing the game state
+ * @param owner         – zero or the index of the player
+ * @return Data of @p owner or NULL if the allocation has failed.
+ */
+Owner edit_owner(gamma_t *g, uint32_t owner);
+
+/** @brief Copies the owners of all the fields of a row.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param y             – index of the row, smaller than the height
+ * @param owners        – array of width elements, where owners[x]
+ *                        is set to the owner of the field (x, y)
+ */
+void get_row_owners(gamma_t *g, uint32_t y, uint32_t *owners);
+
+/** @brief Returns the index of the field with position @p position.
+ *
+ * Fields are numbered row by row, starting from the bottom left corner.
+ * @param g             – pointer to the structure storing the game state
+ * @param position      – position lying inside the board
+ * @return Number in range [0, width * height).
+ */
+uint64_t cell_index(gamma_t *g, Position position);
+
+/** @brief Returns the position of the field with index @p cell.
+ *
+ * Inverse of @ref cell_index.
+ * @param g             – pointer to the structure storing the game state
+ * @param cell          – number in range [0, width * height)
+ */
+Position cell_position(gamma_t *g, uint64_t cell);
+
+/** @brief Changes the owner of the field and updates the frontiers.
+ *
+ * Sets the owner of the field in slot @p slot
+ * and updates the frontier of every player whose neighbourhood
+ * has changed (see @ref OwnerData.frontier).
+ * The number of fields and areas of the owners is not updated,
+ * but once this function succeeds @ref edit_owner
+ * does not fail for the old and the new owner.
  * @param g             – pointer to the structure storing the game state
- * @return Field with postion @p postion
- * or NULL if @p position is not @ref inside_board.
+ * @param slot          – slot of a field inside the board
+ * @param new_owner     – zero or the index of the player
+ * @return False if the allocation has failed
+ *         (in which case nothing is changed), true otherwise.
  */
-Field get_field(gamma_t *g, Position position);
+bool set_owner(gamma_t *g, uint64_t slot, uint32_t new_owner);
 
-/** @brief Checks if fields with positions @p a and @p b lie in the same area
+/** @brief Checks if fields in slots @p a and @p b lie in the same area
  *
  * @p a and @p b are said to be in the same area iff
  * one can get from @a to @b
@@ -31,32 +175,72 @@ Field get_field(gamma_t *g, Position position);
  * using only free fields.
  *
  * @param g                    – pointer to the structure storing the game state
- * @param a                    – the first position
- * @param g                    – the second position
+ * @param a                    – the first slot
+ * @param b                    – the second slot
  * @return True if @p a and @p b lie in the same area, false otherwise.
  */
-bool are_in_the_same_area(gamma_t *g, Position a, Position b);
+bool are_in_the_same_area(gamma_t *g, uint64_t a, uint64_t b);
 
-/** @brief Counts neighbouring areas
+/** @brief Counts the areas the neighbours of a field would form without it
  *
- * Counts all areas that contain at least
- * one of the neighbours of @p position and belong to the player
- * with index @p player.
+ * Counts the areas of the owner of the field in slot @p slot
+ * that would contain at least one of its neighbours
+ * if the owner lost the field, i.e. the number of areas
+ * the area of the field would split into.
  * For more information on areas, check @ref are_in_the_same_area.
  * @param g                    – pointer to the structure storing the game state
- * @param player               – player whose areas to count
- * @param position             – position whose neighbouring areas are counted
- * @param include_center       – if true, consider @p position
- *                               as a neighbour itself
- *                               (i.e. also count areas that contain @p postion
- *                               itself but do not contain any of its proper
- *                               neighbours)
- * @return Number of neighbouring areas.
- *         Note that if @p player is not a real player
- *         (e.g. @p player==0), the function returns 0.
- */
-uint32_t neighbouring_areas(gamma_t *g, uint32_t player,
-                            Position position, bool include_center);
+ * @param slot                 – slot of a field inside the board
+ * @return Number of the areas, in range [0, 4].
+ *         Note that if the field is free the function returns 0.
+ */
+uint32_t areas_without(gamma_t *g, uint64_t slot);
+
+/** @brief Growable array of slots
+ */
+typedef struct Slots {
+    uint64_t *slots;    /**< The slots, NULL until the first one */
+    uint64_t count;     /**< Number of the slots */
+    uint64_t capacity;  /**< Length of the allocated array */
+} Slots;
+
+/** @brief Appends a slot to the array.
+ *
+ * @param slots         – the array, {0} if empty
+ * @param slot          – the slot to append
+ * @return False if the allocation has failed, true otherwise.
+ */
+bool slots_append(Slots *slots, uint64_t slot);
 
+/** @brief Frees the slots of the array and empties it.
+ */
+void slots_free(Slots *slots);
+
+/** @brief Collects the fields of an area.
+ *
+ * Appends to @p fields the slots of all the fields of the area
+ * containing the field in slot @p start, walking around the field
+ * in slot @p blocked as if it had another owner.
+ * The collected fields are marked in the bitmap of the current thread
+ * (see @ref scratch.h) and marked fields are not collected again,
+ * so collecting from a field of an area already collected
+ * appends nothing. The caller must unmark the fields with
+ * @ref unmark_fields before any other search in the thread,
+ * also if this function fails.
+ * @param g             – pointer to the structure storing the game state
+ * @param start         – slot of a field inside the board
+ * @param blocked       – slot the function is not allowed to visit
+ *                        or @ref NO_SLOT
+ * @param fields        – the array to append to
+ * @return False if the allocation has failed, true otherwise.
+ */
+bool collect_area(gamma_t *g, uint64_t start, uint64_t blocked,
+                  Slots *fields);
+
+/** @brief Unmarks the fields marked by @ref collect_area.
+ *
+ * @param g             – pointer to the structure storing the game state
+ * @param fields        – the array passed to @ref collect_area
+ */
+void unmark_fields(gamma_t *g, const Slots *fields);
 
 #endif //BOARD_H
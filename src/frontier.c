@@ -0,0 +1,249 @@
+/** @file
+ * Implementation of the frontier set interface
+ *
+ * The set is an open addressing hash table with linear probing.
+ * Removal shifts the following entries back instead of leaving
+ * tombstones, so the table never degrades after many moves.
+ * The slots are kept on pages shared copy-on-write with the forks
+ * of the game (see @ref pages.h), so only the pages touched by a move
+ * are copied.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "frontier.h"
+#include "pages.h"
+
+/** @brief Value marking an unused slot of the table,
+ * a used slot stores the index of its field plus one
+ */
+#define EMPTY_SLOT 0
+
+/** @brief Number of slots of a newly created table, must be a power of two
+ */
+#define INITIAL_CAPACITY 16
+
+typedef struct FrontierData {
+    Pages slots;       /**< Table of size @p capacity, zero-filled
+                            and shared copy-on-write with the forks,
+                            unused slots store @ref EMPTY_SLOT */
+    uint64_t capacity; /**< Number of slots, always a power of two */
+    uint64_t size;     /**< Number of fields stored in the set */
+    atomic_uint_fast64_t refcount; /**< Number of owners sharing the set,
+                                        possibly in different threads */
+} *Frontier;
+
+/** @brief Returns the slot where the search for @p cell starts.
+ *
+ * @param capacity      – number of slots of the table
+ * @param cell          – index of the field
+ */
+static uint64_t home_slot(uint64_t capacity, uint64_t cell) {
+    // Fibonacci hashing, consecutive cells end up far apart
+    return (cell * UINT64_C(0x9E3779B97F4A7C15)) & (capacity - 1);
+}
+
+/** @brief Returns the value stored in the slot @p i.
+ */
+static uint64_t get_slot(Frontier frontier, uint64_t i) {
+    return *(const uint64_t *) pages_read(frontier->slots, i);
+}
+
+/** @brief Stores @p value in the slot @p i.
+ *
+ * The page of the slot must have been made private
+ * by @ref frontier_prepare.
+ */
+static void set_slot(Frontier frontier, uint64_t i, uint64_t value) {
+    *(uint64_t *) pages_write(frontier->slots, i) = value;
+}
+
+/** @brief Doubles the number of slots of the table.
+ *
+ * @return False if the allocation has failed (the set is left unchanged),
+ *         true otherwise.
+ */
+static bool frontier_grow(Frontier frontier) {
+    uint64_t new_capacity = 2 * frontier->capacity;
+    Pages new_slots = pages_new(new_capacity, sizeof(uint64_t), NULL, NULL);
+    if (new_slots == NULL)
+        return false;
+
+    for (uint64_t i = 0; i < frontier->capacity; i++) {
+        uint64_t value = get_slot(frontier, i);
+        if (value != EMPTY_SLOT) {
+            uint64_t j = home_slot(new_capacity, value - 1);
+            while (*(const uint64_t *) pages_read(new_slots, j) != EMPTY_SLOT)
+                j = (j + 1) & (new_capacity - 1);
+
+            uint64_t *slot = pages_write(new_slots, j);
+            if (slot == NULL) {
+                pages_delete(new_slots);
+                return false;
+            }
+            *slot = value;
+        }
+    }
+
+    pages_delete(frontier->slots);
+    frontier->slots = new_slots;
+    frontier->capacity = new_capacity;
+    return true;
+}
+
+Frontier frontier_new() {
+    Frontier result = malloc(sizeof(struct FrontierData));
+    if (result == NULL)
+        return NULL;
+
+    result->slots = pages_new(INITIAL_CAPACITY, sizeof(uint64_t), NULL, NULL);
+    if (result->slots == NULL) {
+        free(result);
+        return NULL;
+    }
+    result->capacity = INITIAL_CAPACITY;
+    result->size = 0;
+    atomic_init(&result->refcount, 1);
+
+    return result;
+}
+
+void frontier_insert(Frontier frontier, uint64_t cell) {
+    uint64_t i = home_slot(frontier->capacity, cell);
+    uint64_t value;
+    while ((value = get_slot(frontier, i)) != EMPTY_SLOT) {
+        if (value == cell + 1)
+            return;
+        i = (i + 1) & (frontier->capacity - 1);
+    }
+
+    set_slot(frontier, i, cell + 1);
+    frontier->size++;
+}
+
+bool frontier_reserve(Frontier frontier, uint64_t count) {
+    // Keep the load factor below one half,
+    // if the table cannot grow keep on filling it while there's room
+    while (2 * (frontier->size + count) > frontier->capacity)
+        if (!frontier_grow(frontier))
+            return frontier->size + count < frontier->capacity;
+    return true;
+}
+
+bool frontier_prepare(Frontier frontier, uint64_t cell, uint64_t changes) {
+    uint64_t mask = frontier->capacity - 1;
+    uint64_t page_mask = pages_page_size(frontier->slots) - 1;
+
+    // Searching for a field and shifting the entries back stop
+    // at the first unused slot. Each of the other changes may fill
+    // one unused slot, so the search may go as far as the next one.
+    uint64_t i = home_slot(frontier->capacity, cell);
+    uint64_t unused = 0;
+    for (uint64_t j = 0; j < frontier->capacity && unused <= changes; j++) {
+        if ((j == 0 || (i & page_mask) == 0) &&
+            pages_write(frontier->slots, i) == NULL)
+            return false;
+        if (get_slot(frontier, i) == EMPTY_SLOT)
+            unused++;
+        i = (i + 1) & mask;
+    }
+
+    return true;
+}
+
+void frontier_remove(Frontier frontier, uint64_t cell) {
+    uint64_t mask = frontier->capacity - 1;
+
+    uint64_t i = home_slot(frontier->capacity, cell);
+    uint64_t value;
+    while ((value = get_slot(frontier, i)) != cell + 1) {
+        if (value == EMPTY_SLOT)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    // Shift back every following entry which would not be found
+    // once slot i becomes unused
+    uint64_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        uint64_t moved = get_slot(frontier, j);
+        if (moved == EMPTY_SLOT)
+            break;
+
+        uint64_t home = home_slot(frontier->capacity, moved - 1);
+        // Entry j may fill the gap iff its home slot
+        // does not lie cyclically in (i, j]
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            set_slot(frontier, i, moved);
+            i = j;
+        }
+    }
+
+    set_slot(frontier, i, EMPTY_SLOT);
+    frontier->size--;
+}
+
+uint64_t frontier_size(Frontier frontier) {
+    if (frontier == NULL)
+        return 0;
+    else
+        return frontier->size;
+}
+
+uint64_t frontier_capacity(Frontier frontier) {
+    if (frontier == NULL)
+        return 0;
+    else
+        return frontier->capacity;
+}
+
+bool frontier_slot(Frontier frontier, uint64_t slot, uint64_t *cell) {
+    uint64_t value = get_slot(frontier, slot);
+    *cell = value - 1;
+    return value != EMPTY_SLOT;
+}
+
+Frontier frontier_share(Frontier frontier) {
+    if (frontier != NULL)
+        atomic_fetch_add_explicit(&frontier->refcount, 1,
+                                  memory_order_relaxed);
+    return frontier;
+}
+
+bool frontier_unshare(Frontier *frontier) {
+    if (*frontier == NULL ||
+        atomic_load_explicit(&(*frontier)->refcount,
+                             memory_order_acquire) == 1)
+        return true;
+
+    Frontier copy = malloc(sizeof(struct FrontierData));
+    if (copy == NULL)
+        return false;
+
+    // The reference count may be changed by another thread meanwhile,
+    // copy only the set itself, its pages are copied once modified
+    copy->capacity = (*frontier)->capacity;
+    copy->size = (*frontier)->size;
+    copy->slots = pages_fork((*frontier)->slots);
+    if (copy->slots == NULL) {
+        free(copy);
+        return false;
+    }
+    atomic_init(&copy->refcount, 1);
+
+    frontier_delete(*frontier);
+    *frontier = copy;
+    return true;
+}
+
+void frontier_delete(Frontier frontier) {
+    if (frontier != NULL &&
+        atomic_fetch_sub_explicit(&frontier->refcount, 1,
+                                  memory_order_acq_rel) == 1) {
+        pages_delete(frontier->slots);
+        free(frontier);
+    }
+}
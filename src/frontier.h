@@ -0,0 +1,128 @@
+/** @file
+ * Interface for managing the frontier of a player
+ *
+ * The frontier of a player is the set of free fields
+ * (fields without a pawn on them) which neighbour
+ * at least one field owned by that player.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Stores data of the whole frontier set.
+ */
+typedef struct FrontierData *Frontier;
+
+/** @brief Allocates an empty frontier set.
+ *
+ * @return Empty frontier set,
+ *         i.e. pointer to the newly allocated FrontierData
+ *         or NULL if the allocation has failed
+ */
+Frontier frontier_new();
+
+/** @brief Inserts a field into the frontier set.
+ *
+ * Does nothing if @p cell is already in the set.
+ * Cannot fail, the room for the field must have been made
+ * by @ref frontier_reserve and the slots it's stored in
+ * by @ref frontier_prepare.
+ * @param frontier      – pointer to the structure storing the set
+ * @param cell          – index of the field, see @ref cell_index
+ */
+void frontier_insert(Frontier frontier, uint64_t cell);
+
+/** @brief Makes sure inserting fields into the frontier set won't fail.
+ *
+ * Makes room for the next @p count calls of @ref frontier_insert.
+ * @param frontier      – pointer to the structure storing the set
+ * @param count         – number of fields to be inserted
+ * @return False if the set is full and could not be enlarged,
+ *         true otherwise.
+ */
+bool frontier_reserve(Frontier frontier, uint64_t count);
+
+/** @brief Makes sure the slots of a field can be modified.
+ *
+ * Copies the pages of the table shared with other sets
+ * which may be modified by inserting or removing @p cell,
+ * if it's one of the next @p changes insertions and removals.
+ * Has to be called after @ref frontier_reserve, which may
+ * rebuild the table.
+ * @param frontier      – pointer to the structure storing the set
+ * @param cell          – index of the field, see @ref cell_index
+ * @param changes       – number of fields to be inserted or removed
+ * @return False if the allocation has failed, true otherwise.
+ */
+bool frontier_prepare(Frontier frontier, uint64_t cell, uint64_t changes);
+
+/** @brief Removes a field from the frontier set.
+ *
+ * Does nothing if @p cell is not in the set.
+ * Cannot fail once @ref frontier_prepare has been called for @p cell.
+ * @param frontier      – pointer to the structure storing the set
+ * @param cell          – index of the field, see @ref cell_index
+ */
+void frontier_remove(Frontier frontier, uint64_t cell);
+
+/** @brief Returns the number of fields in the frontier set.
+ *
+ * @param frontier      – pointer to the structure storing the set
+ *                        or NULL, which is treated as an empty set
+ */
+uint64_t frontier_size(Frontier frontier);
+
+/** @brief Returns the number of slots of the frontier set.
+ *
+ * Together with @ref frontier_slot allows to iterate over the set.
+ * @param frontier      – pointer to the structure storing the set
+ *                        or NULL, which is treated as an empty set
+ */
+uint64_t frontier_capacity(Frontier frontier);
+
+/** @brief Reads a slot of the frontier set.
+ *
+ * The slots remain the same as long as the set is not modified.
+ * @param frontier      – pointer to the structure storing the set
+ * @param slot          – number in range [0, @ref frontier_capacity)
+ * @param cell          – where to save the field stored in the slot
+ * @return True if the slot stores a field, false if it's unused.
+ */
+bool frontier_slot(Frontier frontier, uint64_t slot, uint64_t *cell);
+
+/** @brief Shares the frontier set with another owner.
+ *
+ * The set is not copied, instead it's copied by @ref frontier_unshare
+ * once any of its owners is about to modify it. The slots are kept on
+ * pages shared copy-on-write, so copying the set copies only the table
+ * of pages and @ref frontier_prepare copies the pages to be modified.
+ * @param frontier      – pointer to the structure storing the set
+ *                        or NULL
+ * @return @p frontier
+ */
+Frontier frontier_share(Frontier frontier);
+
+/** @brief Makes sure the frontier set is not shared before modifying it.
+ *
+ * If the set is shared (see @ref frontier_share), replaces it
+ * with its own copy sharing the pages of the slots.
+ * @param frontier      – pointer to the variable storing the set,
+ *                        the set may be NULL
+ * @return False if the allocation has failed, true otherwise.
+ */
+bool frontier_unshare(Frontier *frontier);
+
+/** @brief Drops one owner of the frontier set.
+ *
+ * Frees @p frontier from the memory once it's no longer shared.
+ * Does nothing if @p frontier == NULL.
+ * @param frontier      – pointer to the structure storing the set
+ */
+void frontier_delete(Frontier frontier);
+
+#endif //FRONTIER_H
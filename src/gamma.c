@@ -1,6 +1,8 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "board.h"
+#include "trace.h"
 #include "types.c"
 
 uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
@@ -11,19 +13,50 @@ uint64_t gamma_busy_fields(gamma_t *g, uint32_t player) {
         player > g->number_of_players)
         return 0;
     else
-        return g->owners[player].busy_fields;
+        return get_owner(g, player)->busy_fields;
 }
 
 bool gamma_golden_possible(gamma_t *g, uint32_t player) {
-    if(g == NULL)
+    if (g == NULL || player == 0 || player > g->number_of_players)
         return false;
 
+    uint64_t start = trace_begin();
     bool result = false;
 
     for (uint32_t i = 1; i <= g->number_of_players; i++) {
-        if (i != player && g->owners[i].busy_fields > 0)
-            result = !g->owners[player].golden_move_used;
+        if (i != player && get_owner(g, i)->busy_fields > 0)
+            result = !get_owner(g, player)->golden_move_used;
     }
 
+    trace_end("gamma_golden_possible", start);
     return result;
-}
\ No newline at end of file
+}
+
+uint64_t gamma_hash(gamma_t *g) {
+    if (g == NULL)
+        return 0;
+    else
+        return g->hash;
+}
+
+bool gamma_set_threads(gamma_t *g, uint32_t threads) {
+    if (g == NULL || threads == 0)
+        return false;
+
+    g->threads = threads;
+    return true;
+}
+
+bool gamma_stats(gamma_t *g, GammaStats *out) {
+#ifdef GAMMA_STATS
+    if (g == NULL || out == NULL)
+        return false;
+
+    stats_load(&g->stats, out);
+    return true;
+#else
+    (void) g;
+    (void) out;
+    return false;
+#endif
+}
@@ -20,8 +20,12 @@
 
 #include "memory.h"
 #include "board.h"
+#include "areas.h"
 #include "moves.h"
 #include "print.h"
+#include "ai.h"
+#include "stats.h"
+#include "snapshot.h"
 
 /** @brief Number of fields owned by a player.
  *
@@ -46,4 +50,39 @@ uint64_t gamma_busy_fields(gamma_t *g, uint32_t player);
  */
 bool gamma_golden_possible(gamma_t *g, uint32_t player);
 
+/** @brief Returns the hash of the game state.
+ *
+ * The hash depends on the owners of all the fields and on which players
+ * have already used their golden move. It's updated with every move,
+ * so reading it costs nothing. Equal game states of games with the same
+ * parameters have equal hashes, also in different processes.
+ * @param[in] g       – pointer to the structure storing the game state
+ * @return 64-bit hash of the game state or zero if @p g == NULL.
+ */
+uint64_t gamma_hash(gamma_t *g);
+
+/** @brief Sets the number of threads scanning the whole board.
+ *
+ * Scans of the whole board, like @ref gamma_board, are split
+ * into stripes of rows run by @p threads threads at once,
+ * but by no more threads than the calling one and one per processor,
+ * see @ref pool.h. A fork of the game starts with the same number.
+ * @param[in] g       – pointer to the structure storing the game state
+ * @param threads     – number of threads, positive number,
+ *                      one means scanning in the calling thread only
+ * @return @p true, if the number has been set, @p false if
+ * @p g == NULL or @p threads == 0.
+ */
+bool gamma_set_threads(gamma_t *g, uint32_t threads);
+
+/** @brief Reads the counters of the work done by the engine.
+ *
+ * See @ref stats.h.
+ * @param[in] g       – pointer to the structure storing the game state
+ * @param[out] out    – where to store the counters
+ * @return @p true, if the counters have been stored, @p false if
+ * @p g or @p out is NULL or the counters are compiled out.
+ */
+bool gamma_stats(gamma_t *g, GammaStats *out);
+
 #endif /* GAMMA_H */
@@ -0,0 +1,435 @@
+/** @file
+ * Benchmarks of the public interface of the game gamma
+ *
+ * Times the functions of gamma.h on boards of various sizes, numbers
+ * of players and area limits, for random and adversarial sequences
+ * of moves. For every function prints the time and the number
+ * of allocations per call, as a table or, with the option -j, as JSON.
+ *
+ * Usage: gamma_bench [-j] [seed]
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "gamma.h"
+
+/** @brief Number of golden moves tried in every benchmark
+ */
+#define GOLDEN_ATTEMPTS 64
+
+/** @brief Number of boards printed in every benchmark
+ */
+#define BOARD_REPEATS 8
+
+/** @brief Number of threads rendering the board in the parallel measurement
+ */
+#define BOARD_THREADS 4
+
+/** @brief Minimal number of calls of the cheap functions in every benchmark
+ */
+#define QUERY_CALLS 100000
+
+/** @brief Number of allocations made so far
+ *
+ * Counted only if the benchmark is linked with the allocation
+ * functions wrapped (see CMakeLists.txt), stays zero otherwise.
+ * Atomic, as the threads rendering the board allocate too.
+ */
+static atomic_uint_fast64_t allocations = 0;
+
+/** @brief True if the allocations are counted
+ */
+#ifdef GAMMA_BENCH_WRAP_MALLOC
+static const bool counting_allocations = true;
+
+/** @brief The original malloc, see the linker option --wrap */
+void *__real_malloc(size_t size);
+/** @brief The original calloc, see the linker option --wrap */
+void *__real_calloc(size_t count, size_t size);
+/** @brief The original realloc, see the linker option --wrap */
+void *__real_realloc(void *pointer, size_t size);
+
+/** @brief Counts an allocation made by any thread */
+static void count_allocation(void) {
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+}
+
+/** @brief Counts the allocation and calls the original malloc */
+void *__wrap_malloc(size_t size) {
+    count_allocation();
+    return __real_malloc(size);
+}
+
+/** @brief Counts the allocation and calls the original calloc */
+void *__wrap_calloc(size_t count, size_t size) {
+    count_allocation();
+    return __real_calloc(count, size);
+}
+
+/** @brief Counts the allocation and calls the original realloc */
+void *__wrap_realloc(void *pointer, size_t size) {
+    count_allocation();
+    return __real_realloc(pointer, size);
+}
+#else
+static const bool counting_allocations = false;
+#endif
+
+/** @brief Describes a single benchmark
+ */
+typedef struct Benchmark {
+    const char *workload; /**< Name of the sequence of moves */
+    uint32_t width;       /**< Width of the board */
+    uint32_t height;      /**< Height of the board */
+    uint32_t players;     /**< Number of players */
+    uint32_t areas;       /**< Maximal number of areas of a player */
+} Benchmark;
+
+/** @brief Measurement of a single function
+ */
+typedef struct Measurement {
+    uint64_t calls;       /**< Number of calls */
+    uint64_t nanoseconds; /**< Total time of the calls */
+    uint64_t allocations; /**< Total number of allocations of the calls */
+} Measurement;
+
+/** @brief State of the pseudorandom generator (xorshift64*)
+ */
+static uint64_t seed = 42;
+
+/** @brief Returns a pseudorandom number from [0, @p bound).
+ */
+static uint64_t random_below(uint64_t bound) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return (seed * UINT64_C(0x2545F4914F6CDD1D)) % bound;
+}
+
+/** @brief Returns the current time in nanoseconds.
+ */
+static uint64_t now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+/** @brief Starts measuring a group of calls.
+ *
+ * @param start         – where to store the starting time
+ * @param start_allocs  – where to store the starting number of allocations
+ */
+static void measure_start(uint64_t *start, uint64_t *start_allocs) {
+    *start_allocs = atomic_load_explicit(&allocations, memory_order_relaxed);
+    *start = now();
+}
+
+/** @brief Adds a group of calls to the measurement.
+ *
+ * @param m             – the measurement
+ * @param calls         – number of calls in the group
+ * @param start         – time from @ref measure_start
+ * @param start_allocs  – number of allocations from @ref measure_start
+ */
+static void measure_stop(Measurement *m, uint64_t calls,
+                         uint64_t start, uint64_t start_allocs) {
+    m->nanoseconds += now() - start;
+    m->allocations += atomic_load_explicit(&allocations,
+                                           memory_order_relaxed) -
+                      start_allocs;
+    m->calls += calls;
+}
+
+/** @brief Plays random moves of random players.
+ *
+ * @return Number of calls of @ref gamma_move.
+ */
+static uint64_t play_random(gamma_t *g, const Benchmark *b) {
+    uint64_t calls = 2 * (uint64_t) b->width * b->height;
+    for (uint64_t i = 0; i < calls; i++)
+        gamma_move(g, (uint32_t) random_below(b->players) + 1,
+                   (uint32_t) random_below(b->width),
+                   (uint32_t) random_below(b->height));
+    return calls;
+}
+
+/** @brief Tells whether field (@p x, @p y) belongs to the snake.
+ *
+ * The snake fills every even row and joins them alternately
+ * at the right and at the left edge of the board, making
+ * a single area as long as possible.
+ */
+static bool on_snake(uint32_t x, uint32_t y, uint32_t width) {
+    if (y % 2 == 0)
+        return true;
+    else if (y % 4 == 1)
+        return x == width - 1;
+    else
+        return x == 0;
+}
+
+/** @brief Lets player 1 lay a single long snake along the board.
+ *
+ * Every golden move of another player onto the snake
+ * cuts it into two long areas.
+ * @return Number of calls of @ref gamma_move.
+ */
+static uint64_t play_snake(gamma_t *g, const Benchmark *b) {
+    uint64_t calls = 0;
+    for (uint32_t y = 0; y < b->height; y++) {
+        for (uint32_t i = 0; i < b->width; i++) {
+            // Follow the snake so that the area never splits
+            uint32_t x = (y % 4 < 2) ? i : b->width - 1 - i;
+            if (on_snake(x, y, b->width)) {
+                gamma_move(g, 1, x, y);
+                calls++;
+            }
+        }
+    }
+    return calls;
+}
+
+/** @brief Fills the board with a checkerboard of players 1 and 2.
+ *
+ * Every field is a separate area and every golden move
+ * merges up to four areas.
+ * @return Number of calls of @ref gamma_move.
+ */
+static uint64_t play_checkerboard(gamma_t *g, const Benchmark *b) {
+    for (uint32_t y = 0; y < b->height; y++)
+        for (uint32_t x = 0; x < b->width; x++)
+            gamma_move(g, (x + y) % 2 + 1, x, y);
+    return (uint64_t) b->width * b->height;
+}
+
+/** @brief Chooses a golden move to try after the workload.
+ *
+ * @param b             – the benchmark
+ * @param player        – where to store the player
+ * @param x             – where to store the column
+ * @param y             – where to store the row
+ */
+static void golden_target(const Benchmark *b, uint32_t *player,
+                          uint32_t *x, uint32_t *y) {
+    *x = (uint32_t) random_below(b->width);
+    *y = (uint32_t) random_below(b->height);
+
+    if (strcmp(b->workload, "snake") == 0) {
+        // A cut of the snake, preferably far from its ends
+        *player = 2;
+        *x = b->width / 2;
+        *y -= *y % 2;
+    } else if (strcmp(b->workload, "checkerboard") == 0) {
+        *player = 2 - (*x + *y) % 2;
+    } else {
+        *player = (uint32_t) random_below(b->players) + 1;
+    }
+}
+
+/** @brief Names of the measured functions
+ */
+enum Function {
+    NEW_DELETE, MOVE, GOLDEN_MOVE, FREE_FIELDS, GOLDEN_POSSIBLE, BOARD,
+    PARALLEL_BOARD, NUMBER_OF_FUNCTIONS
+};
+
+/** @brief Names of the measured functions, as printed
+ */
+static const char *function_names[NUMBER_OF_FUNCTIONS] = {
+        "gamma_new+gamma_delete", "gamma_move", "gamma_golden_move",
+        "gamma_free_fields", "gamma_golden_possible", "gamma_board",
+        "gamma_board (4 threads)"
+};
+
+/** @brief Runs a single benchmark.
+ *
+ * @param b             – the benchmark
+ * @param m             – array of @ref NUMBER_OF_FUNCTIONS measurements
+ * @return False if the allocation has failed, true otherwise.
+ */
+static bool run(const Benchmark *b, Measurement *m) {
+    uint64_t start, start_allocs;
+    memset(m, 0, NUMBER_OF_FUNCTIONS * sizeof(Measurement));
+
+    uint64_t repeats = QUERY_CALLS / ((uint64_t) b->width * b->height) + 1;
+    for (uint64_t i = 0; i < repeats; i++) {
+        measure_start(&start, &start_allocs);
+        gamma_delete(gamma_new(b->width, b->height, b->players, b->areas));
+        measure_stop(&m[NEW_DELETE], 1, start, start_allocs);
+    }
+
+    gamma_t *g = gamma_new(b->width, b->height, b->players, b->areas);
+    if (g == NULL)
+        return false;
+
+    uint64_t calls;
+    measure_start(&start, &start_allocs);
+    if (strcmp(b->workload, "snake") == 0)
+        calls = play_snake(g, b);
+    else if (strcmp(b->workload, "checkerboard") == 0)
+        calls = play_checkerboard(g, b);
+    else
+        calls = play_random(g, b);
+    measure_stop(&m[MOVE], calls, start, start_allocs);
+
+    for (uint64_t i = 0; i < GOLDEN_ATTEMPTS; i++) {
+        // Every attempt starts from the same position,
+        // a player can make only one golden move in a game
+        gamma_t *fork = gamma_fork(g);
+        if (fork == NULL) {
+            gamma_delete(g);
+            return false;
+        }
+        uint32_t player, x, y;
+        golden_target(b, &player, &x, &y);
+
+        measure_start(&start, &start_allocs);
+        gamma_golden_move(fork, player, x, y);
+        measure_stop(&m[GOLDEN_MOVE], 1, start, start_allocs);
+
+        gamma_delete(fork);
+    }
+
+    repeats = QUERY_CALLS / b->players + 1;
+    measure_start(&start, &start_allocs);
+    for (uint64_t i = 0; i < repeats; i++)
+        for (uint32_t player = 1; player <= b->players; player++)
+            gamma_free_fields(g, player);
+    measure_stop(&m[FREE_FIELDS], repeats * b->players, start, start_allocs);
+
+    measure_start(&start, &start_allocs);
+    for (uint64_t i = 0; i < repeats; i++)
+        for (uint32_t player = 1; player <= b->players; player++)
+            gamma_golden_possible(g, player);
+    measure_stop(&m[GOLDEN_POSSIBLE], repeats * b->players,
+                 start, start_allocs);
+
+    for (uint64_t i = 0; i < BOARD_REPEATS; i++) {
+        measure_start(&start, &start_allocs);
+        char *board = gamma_board(g);
+        measure_stop(&m[BOARD], 1, start, start_allocs);
+        free(board);
+    }
+
+    gamma_set_threads(g, BOARD_THREADS);
+    for (uint64_t i = 0; i < BOARD_REPEATS; i++) {
+        measure_start(&start, &start_allocs);
+        char *board = gamma_board(g);
+        measure_stop(&m[PARALLEL_BOARD], 1, start, start_allocs);
+        free(board);
+    }
+
+    gamma_delete(g);
+    return true;
+}
+
+/** @brief Prints the results of a single benchmark.
+ *
+ * @param b             – the benchmark
+ * @param m             – array of @ref NUMBER_OF_FUNCTIONS measurements
+ * @param json          – true to print a JSON object per function,
+ *                        false to print a row of a table
+ * @param first         – true if nothing has been printed yet
+ */
+static void report(const Benchmark *b, const Measurement *m,
+                   bool json, bool first) {
+    for (int f = 0; f < NUMBER_OF_FUNCTIONS; f++) {
+        double ns_per_op = (double) m[f].nanoseconds / (double) m[f].calls;
+        double allocs_per_op =
+                (double) m[f].allocations / (double) m[f].calls;
+
+        if (json) {
+            printf("%s\n  {\"function\": \"%s\", \"workload\": \"%s\", "
+                   "\"width\": %" PRIu32 ", \"height\": %" PRIu32 ", "
+                   "\"players\": %" PRIu32 ", \"areas\": %" PRIu32 ", "
+                   "\"calls\": %" PRIu64 ", \"ns_per_op\": %.1f, ",
+                   first && f == 0 ? "" : ",", function_names[f],
+                   b->workload, b->width, b->height, b->players, b->areas,
+                   m[f].calls, ns_per_op);
+            if (counting_allocations)
+                printf("\"allocs_per_op\": %.3f}", allocs_per_op);
+            else
+                printf("\"allocs_per_op\": null}");
+        } else {
+            printf("%-24s %-13s %5" PRIu32 "x%-5" PRIu32 " %3" PRIu32
+                   " %10" PRIu32 " %8" PRIu64 " %14.1f",
+                   function_names[f], b->workload, b->width, b->height,
+                   b->players, b->areas, m[f].calls, ns_per_op);
+            if (counting_allocations)
+                printf(" %10.3f\n", allocs_per_op);
+            else
+                printf(" %10s\n", "-");
+        }
+    }
+}
+
+/** @brief The benchmarks to run
+ */
+static const Benchmark benchmarks[] = {
+        {"random",       10,   10,   2, 2},
+        {"random",       10,   10,   8, 4},
+        {"random",       100,  100,  2, 1},
+        {"random",       100,  100,  4, 16},
+        {"random",       1000, 1000, 8, 64},
+        {"snake",        64,   64,   2, UINT32_MAX},
+        {"snake",        65,   64,   2, UINT32_MAX},
+        {"snake",        100,  100,  2, 1},
+        {"snake",        100,  100,  2, UINT32_MAX},
+        {"snake",        1000, 1000, 2, UINT32_MAX},
+        {"checkerboard", 100,  100,  2, UINT32_MAX},
+        {"checkerboard", 1000, 1000, 2, UINT32_MAX},
+};
+
+/** @brief Runs all the benchmarks.
+ *
+ * @return 0 on success, 1 if the arguments are invalid
+ *         or the allocation has failed.
+ */
+int main(int argc, char *argv[]) {
+    bool json = false;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-j") == 0) {
+        json = true;
+        arg++;
+    }
+    if (arg < argc) {
+        char *end;
+        seed = strtoull(argv[arg++], &end, 10);
+        if (*end != '\0' || seed == 0)
+            arg = argc + 1;
+    }
+    if (arg != argc) {
+        fprintf(stderr, "usage: %s [-j] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    if (json)
+        printf("[");
+    else
+        printf("%-24s %-13s %11s %3s %10s %8s %14s %10s\n", "function",
+               "workload", "board", "pl", "areas", "calls", "ns/op",
+               "allocs/op");
+
+    Measurement m[NUMBER_OF_FUNCTIONS];
+    size_t count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    for (size_t i = 0; i < count; i++) {
+        if (!run(&benchmarks[i], m)) {
+            fprintf(stderr, "allocation failed\n");
+            return 1;
+        }
+        report(&benchmarks[i], m, json, i == 0);
+        fflush(stdout);
+    }
+
+    if (json)
+        printf("\n]\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+/** @file
+ * Generator of batch mode inputs for load testing
+ *
+ * Prints to the standard output a batch mode input (see batch.h)
+ * of a seeded scenario:
+ *  - random   – a random mix of all the commands,
+ *  - pressure – many players with a tight area limit
+ *               making moves all over the board,
+ *  - golden   – the board half-filled, then a storm of golden moves,
+ *  - query    – the board half-filled, then mostly 'f', 'q', 'b' and 'p'.
+ *
+ * Usage: gamma_gen scenario seed commands [width height players areas]
+ *
+ * The same arguments always give the same input.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+/** @brief Parameters of the game and of the generated input
+ */
+typedef struct Scenario {
+    const char *name;    /**< Name given on the command line */
+    uint32_t width;      /**< Default width of the board */
+    uint32_t height;     /**< Default height of the board */
+    uint32_t players;    /**< Default number of players */
+    uint32_t areas;      /**< Default maximal number of areas */
+} Scenario;
+
+/** @brief The scenarios with their default game parameters
+ */
+static const Scenario scenarios[] = {
+        {"random",   100, 100, 8,    16},
+        {"pressure", 100, 100, 16,   2},
+        {"golden",   100, 100, 1000, 32},
+        {"query",    100, 100, 8,    16},
+};
+
+/** @brief State of the pseudorandom generator (xorshift64*)
+ */
+static uint64_t seed;
+
+/** @brief Returns a pseudorandom number from [0, @p bound).
+ */
+static uint64_t random_below(uint64_t bound) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return (seed * UINT64_C(0x2545F4914F6CDD1D)) % bound;
+}
+
+/** @brief Prints a command taking a player and a field.
+ *
+ * The player and the field are chosen at random, the player
+ * is occasionally invalid and the field is occasionally
+ * outside the board, unless @p valid is true.
+ */
+static void print_field_command(char command, const Scenario *s, bool valid) {
+    uint32_t spread = valid ? 0 : 1;
+    printf("%c %" PRIu64 " %" PRIu64 " %" PRIu64 "\n", command,
+           random_below((uint64_t) s->players + 2 * spread) + 1 - spread,
+           random_below((uint64_t) s->width + spread),
+           random_below((uint64_t) s->height + spread));
+}
+
+/** @brief Prints a command taking only a player.
+ */
+static void print_player_command(char command, const Scenario *s) {
+    printf("%c %" PRIu64 "\n", command, random_below(s->players) + 1);
+}
+
+/** @brief Prints a single command of the query-heavy mix.
+ */
+static void print_query(const Scenario *s) {
+    uint64_t r = random_below(100);
+    if (r < 40)
+        print_player_command('f', s);
+    else if (r < 80)
+        print_player_command('q', s);
+    else if (r < 95)
+        print_player_command('b', s);
+    else
+        printf("p\n");
+}
+
+/** @brief Prints @p commands commands of the scenario @p s.
+ */
+static void generate(const Scenario *s, uint64_t commands) {
+    // The board is half-filled before the storm of golden moves or queries
+    uint64_t fill = (uint64_t) s->width * s->height / 2;
+    if (fill > commands)
+        fill = commands;
+
+    printf("B %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+           s->width, s->height, s->players, s->areas);
+
+    for (uint64_t i = 0; i < commands; i++) {
+        uint64_t r = random_below(100);
+
+        if (strcmp(s->name, "random") == 0) {
+            if (r < 55)
+                print_field_command('m', s, false);
+            else if (r < 70)
+                print_field_command('g', s, false);
+            else if (r < 94)
+                print_query(s);
+            else
+                printf("p\n");
+        } else if (strcmp(s->name, "pressure") == 0) {
+            if (r < 90)
+                print_field_command('m', s, true);
+            else
+                print_player_command('f', s);
+        } else if (i < fill) {
+            print_field_command('m', s, true);
+        } else if (strcmp(s->name, "golden") == 0) {
+            if (r < 90)
+                print_field_command('g', s, true);
+            else
+                print_player_command('q', s);
+        } else {
+            print_query(s);
+        }
+    }
+}
+
+/** @brief Converts @p str to a positive number not greater than @p max.
+ *
+ * @return False if @p str is not such a number, true otherwise.
+ */
+static bool parse_number(const char *str, uint64_t max, uint64_t *output) {
+    char *end;
+    unsigned long long result = strtoull(str, &end, 10);
+    if (*str < '0' || *str > '9' || *end != '\0' ||
+        result == 0 || result > max)
+        return false;
+    *output = result;
+    return true;
+}
+
+/** @brief Parses the arguments and prints the input.
+ *
+ * @return 0 on success, 1 if the arguments are invalid.
+ */
+int main(int argc, char *argv[]) {
+    const Scenario *chosen = NULL;
+    size_t count = sizeof(scenarios) / sizeof(scenarios[0]);
+    for (size_t i = 0; argc > 1 && i < count; i++)
+        if (strcmp(argv[1], scenarios[i].name) == 0)
+            chosen = &scenarios[i];
+
+    Scenario s;
+    uint64_t commands, parameters[4] = {0};
+    bool correct = chosen != NULL && (argc == 4 || argc == 8) &&
+                   parse_number(argv[2], UINT64_MAX, &seed) &&
+                   parse_number(argv[3], UINT64_MAX, &commands);
+
+    if (correct) {
+        s = *chosen;
+        if (argc == 8) {
+            for (int i = 0; i < 4; i++)
+                correct = correct &&
+                          parse_number(argv[4 + i], UINT32_MAX, &parameters[i]);
+            s.width = parameters[0];
+            s.height = parameters[1];
+            s.players = parameters[2];
+            s.areas = parameters[3];
+        }
+    }
+
+    if (!correct) {
+        fprintf(stderr, "usage: %s random|pressure|golden|query seed commands "
+                        "[width height players areas]\n", argv[0]);
+        return 1;
+    }
+
+    generate(&s, commands);
+    return 0;
+}
@@ -11,77 +11,25 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <ctype.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "gamma.h"
 #include "types.c"
 #include "interactive.h"
 #include "batch.h"
+#include "histogram.h"
+#include "trace.h"
+#include "server.h"
 
-/**@brief Maximum allowed number of tokens
- * i.e. more tokens means the input is invalid
+/**@brief Batch mode commands whose latency can be recorded (option -l)
  */
-#define MAX_NUMBER_OF_TOKENS 5
-
-/** @brief Splits string into tokens
- * Splits @p string with respect to the whitespaces.
- * Function replaces whitespaces in  @p string with \0.
- * e.g. parse("a  bc d") returns {"a","bc","d",NULL}
- * @param string       – input to split into tokens
- * @return Pointer to a NULL terminated array of tokens. Each token is a pointer
- * to some part of the original @p string. The resulting array
- * has no more elements than MAX_NUMBER_OF_TOKENS + 1 ( +1 is for the NULL ).
- * The resulting array must be freed manually.
- */
-static char **parse(char *string) {
-    // Important - initializes tokens as an array of NULLs
-    char **tokens = calloc(MAX_NUMBER_OF_TOKENS + 1, sizeof(char *));
-    if (tokens == NULL)
-        return NULL;
-
-    for (int i = 0; i < MAX_NUMBER_OF_TOKENS + 1 && *string != '\0'; i++) {
-        // Skip all whitespace characters
-        while (*string != '\0' && isspace(*string)) {
-            *string = '\0';
-            string++;
-        }
-
-        // Save position
-        if (*string != '\0')
-            tokens[i] = string;
-
-        // Skip all non-whitespace characters
-        while (*string != '\0' && !isspace(*string))
-            string++;
-    }
-
-    return tokens;
-}
+static const char LATENCY_COMMANDS[] = "mgbfqpasrc";
 
-/** @brief Converts string to uint32_t
- * The function tries to convert @p str to uint32_t. If it suceeds,
- * the result is saved in @p output
- * @param str           - string to be converted
- * @param output        - where to save the output
- * @return true if the conversion was successful, false otherwise
+/**@brief Number of elements of @ref LATENCY_COMMANDS
  */
-static bool strToInt(char *str, uint32_t *output) {
-    if (str == NULL)
-        return false;
-
-    uint64_t result = 0;
-    while (*str != '\0') {
-        if (*str >= '0' && *str <= '9' && result <= UINT32_MAX)
-            result = 10 * result + (*str - '0');
-        else
-            return false;
-        str++;
-    }
-    if (result <= UINT32_MAX)
-        *output = result;
-    return result <= UINT32_MAX;
-}
+#define NUMBER_OF_LATENCY_COMMANDS (sizeof(LATENCY_COMMANDS) - 1)
 
 /** @brief enum for storing current state of the game
  *  NO_MODE      - No mode has been selected yet
@@ -104,28 +52,109 @@ static bool stripNewline(char *string) {
     }
 }
 
-/** @brief Returns the number of tokens given by @p parse
- * @param tokens        - output of @p parse function
- * @return minimum of:
- * number of non-NULL elements of @p tokens
- * MAX_NUMBER_OF_TOKENS+1
+/** @brief Returns the current time in nanoseconds
  */
-uint32_t numberOfTokens(char **tokens) {
-    uint32_t result = 0;
-    while (result <= MAX_NUMBER_OF_TOKENS + 1 &&
-           *(tokens++) != NULL)
-        result++;
-    return result;
+static uint64_t nanoseconds() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
 }
 
+/** @brief Records the latency of a batch mode command
+ * Does nothing if @p command is not one of LATENCY_COMMANDS
+ * or the allocation of its histogram fails.
+ * @param latencies     - histograms of LATENCY_COMMANDS, NULL until used
+ * @param command       - a one-letter command
+ * @param latency       - time the command took, in nanoseconds
+ */
+static void recordLatency(Histogram *latencies, char command,
+                          uint64_t latency) {
+    const char *found = strchr(LATENCY_COMMANDS, command);
+    if (command == '\0' || found == NULL)
+        return;
+
+    Histogram *histogram = &latencies[found - LATENCY_COMMANDS];
+    if (*histogram == NULL)
+        *histogram = histogram_new();
+    if (*histogram != NULL)
+        histogram_record(*histogram, latency);
+}
+
+/** @brief Prints the latency percentiles of each recorded command
+ * Prints a line per command, the values are in nanoseconds.
+ * @param output        - where to print
+ * @param latencies     - histograms of LATENCY_COMMANDS, NULL until used
+ */
+static void printLatencies(FILE *output, Histogram *latencies) {
+    for (size_t i = 0; i < NUMBER_OF_LATENCY_COMMANDS; i++) {
+        if (latencies[i] != NULL) {
+            fprintf(output,
+                    "%c count=%lu p50=%lu p99=%lu p999=%lu max=%lu\n",
+                    LATENCY_COMMANDS[i],
+                    histogram_count(latencies[i]),
+                    histogram_percentile(latencies[i], 50),
+                    histogram_percentile(latencies[i], 99),
+                    histogram_percentile(latencies[i], 99.9),
+                    histogram_max(latencies[i]));
+        }
+    }
+}
 
 /** @brief The main function
+ * Usage: gamma [-l latency_file] [-t trace_file] [-s socket] [input_file]
+ * With -l the latencies of the batch mode commands are recorded
+ * and printed to latency_file at the end of the input
+ * ("-" means the standard error output).
+ * With -t (or the environment variable GAMMA_TRACE set to a path)
+ * a trace of the session is written to trace_file at the exit,
+ * see trace.h.
+ * With -s the games are played with the clients of a Unix domain socket
+ * instead of the input, see server.h.
  */
 int main(int argc, char **argv) {
 
+    FILE *latencyOutput = NULL;
+    const char *tracePath = getenv("GAMMA_TRACE");
+    const char *socketPath = NULL;
+    bool optionsCorrect = true;
+    int option;
+    while ((option = getopt(argc, argv, "l:t:s:")) != -1) {
+        switch (option) {
+            case 'l':
+                if (strcmp(optarg, "-") == 0)
+                    latencyOutput = stderr;
+                else
+                    latencyOutput = fopen(optarg, "w");
+                optionsCorrect = optionsCorrect && latencyOutput != NULL;
+                break;
+            case 't':
+                tracePath = optarg;
+                break;
+            case 's':
+                socketPath = optarg;
+                break;
+            default:
+                optionsCorrect = false;
+        }
+    }
+    if (optionsCorrect && tracePath != NULL && *tracePath != '\0')
+        optionsCorrect = trace_start(tracePath);
+
+    if (!optionsCorrect) {
+        fprintf(stderr, "usage: %s [-l latency_file] [-t trace_file] "
+                        "[-s socket] [input_file]\n", argv[0]);
+        return 1;
+    }
+    if (socketPath != NULL)
+        return server(socketPath) ? 0 : 1;
+
+    Histogram latencies[NUMBER_OF_LATENCY_COMMANDS] = {NULL};
+    // The batch mode scans the board (p and c) on all the processors
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
     FILE *input = stdin;
-    if (argc > 1) {
-        input = fopen(argv[1], "r");
+    if (argc > optind) {
+        input = fopen(argv[optind], "r");
     }
 
     char *buffer = NULL;
@@ -133,10 +162,12 @@ int main(int argc, char **argv) {
     enum Mode mode = NO_MODE;
 
     gamma_t *g = NULL;
+    uint32_t computers = 0;
 
     for (uint32_t i = 1; getline(&buffer, &len, input) != -1; i++) {
 
         stripNewline(buffer);
+        uint64_t commandStart = trace_begin();
 
         // Flag to indicate whether the input is correct
         bool correct = true;
@@ -144,70 +175,65 @@ int main(int argc, char **argv) {
         if (*buffer != '\0' && *buffer != '#') {
             // If it's not a comment or an empty line
 
-            char **tokens = parse(buffer);
-            if (tokens == NULL)
-                // malloc failure
-                return 0;
-
-            if (numberOfTokens(tokens) >= 1) {
-                uint32_t numberOfArgs = numberOfTokens(tokens) - 1;
-
-                // Convert string tokens to integer arguments
-                uint32_t *args = malloc(numberOfArgs * sizeof(uint32_t));
-                if (args == NULL)
-                    // malloc failure
-                    return 0;
-
-                for (uint32_t j = 0; j < numberOfArgs; j++)
-                    // Convert until one of the arguments is invalid
-                    correct = correct && strToInt(tokens[j + 1], &args[j]);
-
-                if (strlen(tokens[0]) == 1 && correct) {
-                    char command = tokens[0][0];
-
-                    if (mode == BATCH) {
-                        correct = batch(g, command, args, numberOfArgs);
-                    } else if ((command == 'B' || command == 'I') &&
-                               numberOfArgs == 4 &&
-                               (g = gamma_new(args[0], args[1],
-                                              args[2], args[3])) != NULL) {
-
-                        switch (command) {
-                            case 'B':
-                                mode = BATCH;
-                                break;
-                            case 'I':
-                                mode = INTERACTIVE;
-                        };
-                        printf("OK %u\n", i);
-                    } else {
-                        // Invalid command
-                        correct = false;
-                    }
-                } else {
-                    // Command consists of more than one character
-                    // or integer conversion has failed
-                    correct = false;
-                }
-                free(args);
+            char command;
+            uint32_t args[MAX_NUMBER_OF_ARGS];
+            uint32_t numberOfArgs;
+
+            if (!parseCommand(buffer, &command, args, &numberOfArgs)) {
+                // Command consists of more than one character,
+                // integer conversion has failed or there are only whitespaces
+                correct = false;
+            } else if (mode == BATCH) {
+                uint64_t start = nanoseconds();
+                correct = batch(g, command, args, numberOfArgs, stdout);
+                if (correct && latencyOutput != NULL)
+                    recordLatency(latencies, command,
+                                  nanoseconds() - start);
+            } else if ((numberOfArgs == 4 ||
+                        (command == 'I' && numberOfArgs == 5 &&
+                         args[4] <= args[2])) &&
+                       (command == 'B' || command == 'I') &&
+                       (g = gamma_new(args[0], args[1],
+                                      args[2], args[3])) != NULL) {
+
+                switch (command) {
+                    case 'B':
+                        mode = BATCH;
+                        gamma_set_threads(g, processors > 0 ?
+                                             (uint32_t) processors : 1);
+                        break;
+                    case 'I':
+                        mode = INTERACTIVE;
+                        // The optional fifth argument is the number
+                        // of players controlled by the computer
+                        if (numberOfArgs == 5)
+                            computers = args[4];
+                };
+                printf("OK %u\n", i);
             } else {
-                // not a comment nor an empty line
-                // but there are only whitespaces
+                // Invalid command
                 correct = false;
             }
-            free(tokens);
         }
 
         if (!correct)
             fprintf(stderr, "ERROR %u\n", i);
-
+        trace_end("command", commandStart);
 
         if (mode == INTERACTIVE) {
-            interactive(g);
+            interactive(g, computers);
             break;
         }
     }
 
+    if (latencyOutput != NULL) {
+        printLatencies(latencyOutput, latencies);
+        if (latencyOutput != stderr)
+            fclose(latencyOutput);
+    }
+    for (size_t j = 0; j < NUMBER_OF_LATENCY_COMMANDS; j++)
+        histogram_delete(latencies[j]);
+
     free(buffer);
     gamma_delete(g);
 
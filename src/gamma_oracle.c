@@ -0,0 +1,863 @@
+/** @file
+ * Differential test of the engine against a reference oracle
+ *
+ * The oracle is a deliberately naive implementation of the rules:
+ * plain arrays and areas counted from scratch by a flood fill after
+ * every hypothetical move. Random games are played on both the engine
+ * and the oracle, comparing every returned value and board.
+ * When they differ, the failing game is shrunk to a short sequence
+ * of commands still showing the difference, which is printed
+ * as a batch mode input.
+ *
+ * Usage: gamma_oracle [seed [operations]]
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "gamma.h"
+#include "bitboard.h"
+
+/** @brief Largest width and height of the random boards
+ */
+#define MAX_BOARD_SIZE 8
+
+/** @brief Largest number of players of the random games
+ */
+#define MAX_PLAYERS 12
+
+/** @brief Largest width of the occasional wide boards, one or two rows high
+ */
+#define MAX_WIDE_BOARD_SIZE 80
+
+/** @brief Largest width of the occasional tall boards without bitboards,
+ *         which span several blocks (see blocks.h) in both directions
+ */
+#define MAX_TALL_BOARD_WIDTH 100
+
+/** @brief Smallest height of the tall boards, more than a block
+ */
+#define MIN_TALL_BOARD_HEIGHT 33
+
+/** @brief Largest height of the tall boards
+ */
+#define MAX_TALL_BOARD_HEIGHT 80
+
+/** @brief Largest number of players of the tall boards,
+ *         few enough for their areas to grow across the blocks
+ */
+#define MAX_TALL_BOARD_PLAYERS 8
+
+/** @brief Largest number of players of the occasional crowded games,
+ *         whose boards have wider columns
+ */
+#define MAX_MANY_PLAYERS 1200
+
+/** @brief Largest area limit of the random games
+ */
+#define MAX_AREAS 5
+
+/** @brief Stores the state of a game of the oracle
+ */
+typedef struct Oracle {
+    uint32_t width;      /**< Width of the board */
+    uint32_t height;     /**< Height of the board */
+    uint32_t players;    /**< Number of players */
+    uint32_t areas;      /**< Maximal number of areas of a player */
+    uint32_t *board;     /**< Owner of the field (x, y) is
+                              board[y * width + x], zero if free */
+    bool *golden_used;   /**< golden_used[p] tells whether player p
+                              has made his golden move */
+} Oracle;
+
+/** @brief A single operation of a random game
+ */
+typedef struct Operation {
+    char command;        /**< 'm', 'g', 'b', 'f', 'q', 'r', 'p', 'c' as
+                              in the batch mode, 'l' to list the legal moves,
+                              'k' to replace the game with its fork */
+    uint32_t player;     /**< Argument of the command */
+    uint32_t x;          /**< Argument of the command */
+    uint32_t y;          /**< Argument of the command */
+} Operation;
+
+/** @brief A random game
+ */
+typedef struct Trace {
+    uint32_t width;        /**< Width of the board */
+    uint32_t height;       /**< Height of the board */
+    uint32_t players;      /**< Number of players */
+    uint32_t areas;        /**< Maximal number of areas of a player */
+    Operation *operations; /**< The operations, in order */
+    size_t length;         /**< Number of the operations */
+} Trace;
+
+/** @brief Mixes the size and the bounding box of an area into a number.
+ *
+ * The sum of the numbers of all the areas of a player does not depend
+ * on their order, so it can be compared between the engine
+ * and the oracle.
+ */
+static uint64_t area_digest(uint64_t size, uint32_t min_x, uint32_t min_y,
+                            uint32_t max_x, uint32_t max_y) {
+    uint64_t result = size;
+    uint32_t bounds[4] = {min_x, min_y, max_x, max_y};
+    for (int i = 0; i < 4; i++)
+        result = (result ^ bounds[i]) * UINT64_C(0x100000001B3);
+    return result ^ (result >> 29);
+}
+
+/** @brief Counts the areas of @p player.
+ *
+ * @param o             – the oracle
+ * @param player        – the player
+ * @param digest        – where to store the sum of @ref area_digest
+ *                        of the areas or NULL
+ * @return Number of the areas.
+ */
+static uint32_t oracle_areas(Oracle *o, uint32_t player, uint64_t *digest) {
+    uint64_t fields = (uint64_t) o->width * o->height;
+    bool *visited = calloc(fields, sizeof(bool));
+    uint64_t *stack = malloc(fields * sizeof(uint64_t));
+    if (visited == NULL || stack == NULL)
+        exit(1);
+
+    uint32_t result = 0;
+    for (uint64_t start = 0; start < fields; start++) {
+        if (o->board[start] != player || visited[start])
+            continue;
+
+        result++;
+        uint64_t size = 0, area_size = 0;
+        uint32_t min_x = UINT32_MAX, min_y = UINT32_MAX, max_x = 0, max_y = 0;
+        stack[size++] = start;
+        visited[start] = true;
+        while (size > 0) {
+            uint64_t cell = stack[--size];
+            uint32_t x = cell % o->width, y = cell / o->width;
+            area_size++;
+            min_x = x < min_x ? x : min_x;
+            min_y = y < min_y ? y : min_y;
+            max_x = x > max_x ? x : max_x;
+            max_y = y > max_y ? y : max_y;
+            uint64_t neighbours[4];
+            int count = 0;
+            if (x > 0)
+                neighbours[count++] = cell - 1;
+            if (x + 1 < o->width)
+                neighbours[count++] = cell + 1;
+            if (y > 0)
+                neighbours[count++] = cell - o->width;
+            if (y + 1 < o->height)
+                neighbours[count++] = cell + o->width;
+            for (int i = 0; i < count; i++) {
+                if (o->board[neighbours[i]] == player &&
+                    !visited[neighbours[i]]) {
+                    visited[neighbours[i]] = true;
+                    stack[size++] = neighbours[i];
+                }
+            }
+        }
+        if (digest != NULL)
+            *digest += area_digest(area_size, min_x, min_y, max_x, max_y);
+    }
+
+    free(visited);
+    free(stack);
+    return result;
+}
+
+/** @brief Tells whether giving the field @p cell to @p player is legal.
+ *
+ * Tries the change and checks the area limit of both the new
+ * and the old owner of the field.
+ */
+static bool oracle_change_valid(Oracle *o, uint32_t player, uint64_t cell) {
+    uint32_t old_owner = o->board[cell];
+    o->board[cell] = player;
+    bool result = oracle_areas(o, player, NULL) <= o->areas &&
+                  (old_owner == 0 ||
+                   oracle_areas(o, old_owner, NULL) <= o->areas);
+    o->board[cell] = old_owner;
+    return result;
+}
+
+/** @brief Tells whether (@p x, @p y) lies on the board
+ *         and @p player is a valid player.
+ */
+static bool oracle_arguments(Oracle *o, uint32_t player,
+                             uint32_t x, uint32_t y) {
+    return player >= 1 && player <= o->players &&
+           x < o->width && y < o->height;
+}
+
+/** @brief The oracle of the validity check of @ref gamma_move */
+static bool oracle_move_valid(Oracle *o, uint32_t player,
+                              uint32_t x, uint32_t y) {
+    if (!oracle_arguments(o, player, x, y))
+        return false;
+
+    uint64_t cell = (uint64_t) y * o->width + x;
+    return o->board[cell] == 0 && oracle_change_valid(o, player, cell);
+}
+
+/** @brief The oracle of @ref gamma_move */
+static bool oracle_move(Oracle *o, uint32_t player, uint32_t x, uint32_t y) {
+    if (!oracle_move_valid(o, player, x, y))
+        return false;
+
+    o->board[(uint64_t) y * o->width + x] = player;
+    return true;
+}
+
+/** @brief The oracle of the validity check of @ref gamma_golden_move */
+static bool oracle_golden_valid(Oracle *o, uint32_t player,
+                                uint32_t x, uint32_t y) {
+    if (!oracle_arguments(o, player, x, y) || o->golden_used[player])
+        return false;
+
+    uint64_t cell = (uint64_t) y * o->width + x;
+    return o->board[cell] != 0 && o->board[cell] != player &&
+           oracle_change_valid(o, player, cell);
+}
+
+/** @brief The oracle of @ref gamma_golden_move */
+static bool oracle_golden_move(Oracle *o, uint32_t player,
+                               uint32_t x, uint32_t y) {
+    if (!oracle_golden_valid(o, player, x, y))
+        return false;
+
+    o->board[(uint64_t) y * o->width + x] = player;
+    o->golden_used[player] = true;
+    return true;
+}
+
+/** @brief The oracle of @ref gamma_busy_fields */
+static uint64_t oracle_busy_fields(Oracle *o, uint32_t player) {
+    if (player == 0 || player > o->players)
+        return 0;
+
+    uint64_t result = 0;
+    for (uint64_t i = 0; i < (uint64_t) o->width * o->height; i++)
+        if (o->board[i] == player)
+            result++;
+    return result;
+}
+
+/** @brief The oracle of @ref gamma_free_fields
+ *
+ * Counts the free fields where a move of @p player is legal.
+ */
+static uint64_t oracle_free_fields(Oracle *o, uint32_t player) {
+    if (player == 0 || player > o->players)
+        return 0;
+
+    uint64_t result = 0;
+    for (uint64_t i = 0; i < (uint64_t) o->width * o->height; i++)
+        if (o->board[i] == 0 && oracle_change_valid(o, player, i))
+            result++;
+    return result;
+}
+
+/** @brief The oracle of @ref gamma_golden_possible
+ *
+ * A player who has not made his golden move may make it
+ * if any other player has a field.
+ */
+static bool oracle_golden_possible(Oracle *o, uint32_t player) {
+    if (player == 0 || player > o->players || o->golden_used[player])
+        return false;
+
+    for (uint64_t i = 0; i < (uint64_t) o->width * o->height; i++)
+        if (o->board[i] != 0 && o->board[i] != player)
+            return true;
+    return false;
+}
+
+/** @brief The oracle of @ref gamma_board */
+static char *oracle_board(Oracle *o) {
+    int digits = snprintf(NULL, 0, "%" PRIu32, o->players);
+    int separator = digits > 1 ? 1 : 0;
+    size_t row = (size_t) o->width * (digits + separator) - separator + 1;
+    char *result = malloc(row * o->height + 1);
+    if (result == NULL)
+        exit(1);
+
+    char *end = result;
+    for (uint32_t y = o->height; y-- > 0;) {
+        for (uint32_t x = 0; x < o->width; x++) {
+            uint32_t owner = o->board[(uint64_t) y * o->width + x];
+            if (owner == 0)
+                end += sprintf(end, "%*s", digits, ".");
+            else
+                end += sprintf(end, "%*" PRIu32, digits, owner);
+            if (separator && x + 1 < o->width)
+                *end++ = ' ';
+        }
+        *end++ = '\n';
+    }
+    *end = '\0';
+    return result;
+}
+
+/** @brief Counts the legal moves of @p player.
+ *
+ * @param o             – the oracle
+ * @param player        – the player
+ * @param golden        – where to store the number of the golden moves
+ * @return Number of the ordinary moves.
+ */
+static uint64_t oracle_legal_moves(Oracle *o, uint32_t player,
+                                   uint64_t *golden) {
+    *golden = 0;
+    for (uint32_t y = 0; y < o->height; y++)
+        for (uint32_t x = 0; x < o->width; x++)
+            if (oracle_golden_valid(o, player, x, y))
+                (*golden)++;
+    return oracle_free_fields(o, player);
+}
+
+/** @brief Counts the legal moves of @p player reported by the engine.
+ *
+ * @param g             – the game
+ * @param player        – the player
+ * @param golden        – where to store the number of the golden moves
+ * @return Number of the ordinary moves.
+ */
+static uint64_t engine_legal_moves(gamma_t *g, uint32_t player,
+                                   uint64_t *golden) {
+    LegalMove buffer[7];
+    uint64_t normal = 0;
+    *golden = 0;
+
+    LegalMoves moves = gamma_legal_moves(g, player);
+    if (moves == NULL)
+        return 0;
+
+    uint32_t n;
+    while ((n = gamma_legal_moves_next(moves, buffer, 7)) > 0)
+        for (uint32_t i = 0; i < n; i++)
+            if (buffer[i].golden)
+                (*golden)++;
+            else
+                normal++;
+
+    gamma_legal_moves_delete(moves);
+    return normal;
+}
+
+/** @brief Mixes the index of a legal move into a number.
+ *
+ * The sum of the numbers of all the legal moves can be compared
+ * between the engine and the oracle.
+ */
+static uint64_t move_digest(uint64_t index) {
+    return (index + 1) * UINT64_C(0x9E3779B97F4A7C15);
+}
+
+/** @brief Checks each field of the board and the ones just beyond it.
+ *
+ * @param o             – the oracle
+ * @param player        – the player
+ * @param golden        – where to store the sum of @ref move_digest
+ *                        of the legal golden moves
+ * @return Sum of @ref move_digest of the legal ordinary moves.
+ */
+static uint64_t oracle_check_moves(Oracle *o, uint32_t player,
+                                   uint64_t *golden) {
+    uint64_t result = 0, index = 0;
+    *golden = 0;
+    for (uint32_t y = 0; y <= o->height; y++) {
+        for (uint32_t x = 0; x <= o->width; x++, index++) {
+            if (oracle_move_valid(o, player, x, y))
+                result += move_digest(index);
+            if (oracle_golden_valid(o, player, x, y))
+                *golden += move_digest(index);
+        }
+    }
+    return result;
+}
+
+/** @brief Checks the same moves as @ref oracle_check_moves
+ *         with @ref gamma_check_moves.
+ *
+ * @param g             – the game
+ * @param o             – the oracle playing the same game
+ * @param player        – the player
+ * @param golden        – where to store the sum of @ref move_digest
+ *                        of the legal golden moves
+ * @return Sum of @ref move_digest of the legal ordinary moves.
+ */
+static uint64_t engine_check_moves(gamma_t *g, const Oracle *o,
+                                   uint32_t player, uint64_t *golden) {
+    uint64_t count = ((uint64_t) o->width + 1) * (o->height + 1);
+    LegalMove *moves = malloc(2 * count * sizeof(LegalMove));
+    bool *results = malloc(2 * count * sizeof(bool));
+    if (moves == NULL || results == NULL)
+        exit(1);
+
+    uint64_t index = 0;
+    for (uint32_t y = 0; y <= o->height; y++) {
+        for (uint32_t x = 0; x <= o->width; x++, index++) {
+            moves[2 * index] = (LegalMove) {x, y, false};
+            moves[2 * index + 1] = (LegalMove) {x, y, true};
+        }
+    }
+
+    uint64_t result = 0;
+    *golden = 0;
+    if (gamma_check_moves(g, player, moves, 2 * count, results, 2)) {
+        for (index = 0; index < count; index++) {
+            if (results[2 * index])
+                result += move_digest(index);
+            if (results[2 * index + 1])
+                *golden += move_digest(index);
+        }
+    }
+
+    free(moves);
+    free(results);
+    return result;
+}
+
+/** @brief Reads the areas of @p player from the registry of the engine.
+ *
+ * Checks that the ids of the fields agree with the listed areas
+ * and with the owners of the fields in the oracle.
+ * @param g             – the game
+ * @param o             – the oracle playing the same game
+ * @param player        – the player
+ * @param digest        – where to store the sum of @ref area_digest
+ *                        of the areas
+ * @return Number of the areas or UINT64_MAX if the ids of the fields
+ *         do not agree with the areas.
+ */
+static uint64_t engine_areas(gamma_t *g, const Oracle *o, uint32_t player,
+                             uint64_t *digest) {
+    uint32_t count = gamma_player_areas(g, player, NULL, 0);
+    uint32_t *areas = malloc(((uint64_t) count + 1) * sizeof(uint32_t));
+    GammaArea *found = calloc((uint64_t) count + 1, sizeof(GammaArea));
+    if (areas == NULL || found == NULL)
+        exit(1);
+    gamma_player_areas(g, player, areas, count);
+
+    bool agree = true;
+    for (uint32_t y = 0; y < o->height; y++) {
+        for (uint32_t x = 0; x < o->width; x++) {
+            uint32_t id = gamma_area_id(g, x, y);
+            uint32_t i = 0;
+            while (i < count && areas[i] != id)
+                i++;
+            if ((o->board[(uint64_t) y * o->width + x] == player) !=
+                (i < count)) {
+                agree = false;
+            } else if (i < count) {
+                GammaArea *area = &found[i];
+                if (area->size++ == 0) {
+                    area->min_x = area->max_x = x;
+                    area->min_y = area->max_y = y;
+                }
+                area->min_x = x < area->min_x ? x : area->min_x;
+                area->min_y = y < area->min_y ? y : area->min_y;
+                area->max_x = x > area->max_x ? x : area->max_x;
+                area->max_y = y > area->max_y ? y : area->max_y;
+            }
+        }
+    }
+
+    *digest = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        GammaArea area;
+        agree = agree && gamma_area(g, areas[i], &area) &&
+                area.player == player && area.size == found[i].size &&
+                area.min_x == found[i].min_x && area.min_y == found[i].min_y &&
+                area.max_x == found[i].max_x && area.max_y == found[i].max_y;
+        *digest += area_digest(area.size, area.min_x, area.min_y,
+                               area.max_x, area.max_y);
+    }
+    if (count > 0)
+        agree = agree && gamma_largest_area(g, player) > 0;
+
+    free(areas);
+    free(found);
+    return agree ? count : UINT64_MAX;
+}
+
+/** @brief Runs @p trace on both the engine and the oracle.
+ *
+ * @param trace         – the game to play
+ * @param verbose       – whether to describe the first difference
+ * @return Number of the operations done until the first difference
+ *         (including the differing one) or zero if there is none.
+ */
+static size_t run(const Trace *trace, bool verbose) {
+    Oracle o = {trace->width, trace->height, trace->players, trace->areas,
+                calloc((uint64_t) trace->width * trace->height,
+                       sizeof(uint32_t)),
+                calloc((uint64_t) trace->players + 1, sizeof(bool))};
+    gamma_t *g = gamma_new(trace->width, trace->height,
+                           trace->players, trace->areas);
+    if (o.board == NULL || o.golden_used == NULL || g == NULL)
+        exit(1);
+
+    size_t result = 0;
+    for (size_t i = 0; i <= trace->length && result == 0; i++) {
+        // After the last operation compare everything once more
+        Operation last = {'p', 0, 0, 0};
+        const Operation *op = i < trace->length ? &trace->operations[i] : &last;
+        uint64_t expected = 0, actual = 0;
+        uint64_t expected_golden = 0, actual_golden = 0;
+        char *expected_board = NULL, *actual_board = NULL;
+
+        switch (op->command) {
+            case 'm':
+                expected = oracle_move(&o, op->player, op->x, op->y);
+                actual = gamma_move(g, op->player, op->x, op->y);
+                break;
+            case 'g':
+                expected = oracle_golden_move(&o, op->player, op->x, op->y);
+                actual = gamma_golden_move(g, op->player, op->x, op->y);
+                break;
+            case 'b':
+                expected = oracle_busy_fields(&o, op->player);
+                actual = gamma_busy_fields(g, op->player);
+                break;
+            case 'f':
+                expected = oracle_free_fields(&o, op->player);
+                actual = gamma_free_fields(g, op->player);
+                break;
+            case 'q':
+                expected = oracle_golden_possible(&o, op->player);
+                actual = gamma_golden_possible(g, op->player);
+                break;
+            case 'l':
+                if (op->player >= 1 && op->player <= o.players)
+                    expected = oracle_legal_moves(&o, op->player,
+                                                  &expected_golden);
+                actual = engine_legal_moves(g, op->player, &actual_golden);
+                break;
+            case 'c':
+                expected = oracle_check_moves(&o, op->player,
+                                              &expected_golden);
+                actual = engine_check_moves(g, &o, op->player,
+                                            &actual_golden);
+                break;
+            case 'r':
+                // The digests are compared like the numbers of golden moves
+                if (op->player >= 1 && op->player <= o.players) {
+                    expected = oracle_areas(&o, op->player, &expected_golden);
+                    actual = engine_areas(g, &o, op->player, &actual_golden);
+                } else {
+                    actual = gamma_player_areas(g, op->player, NULL, 0);
+                }
+                break;
+            case 'k': {
+                gamma_t *fork = gamma_fork(g);
+                if (fork == NULL)
+                    exit(1);
+                gamma_delete(g);
+                g = fork;
+                break;
+            }
+            default:
+                expected_board = oracle_board(&o);
+                actual_board = gamma_board(g);
+        }
+
+        bool same = expected == actual && expected_golden == actual_golden &&
+                    (expected_board == NULL ||
+                     (actual_board != NULL &&
+                      strcmp(expected_board, actual_board) == 0));
+        if (!same) {
+            result = i + 1;
+            if (verbose && expected_board != NULL)
+                fprintf(stderr, "expected board:\n%sactual board:\n%s",
+                        expected_board, actual_board);
+            else if (verbose)
+                fprintf(stderr, "expected %" PRIu64 " (%" PRIu64 " golden), "
+                                "actual %" PRIu64 " (%" PRIu64 " golden)\n",
+                        expected, expected_golden, actual, actual_golden);
+        }
+
+        free(expected_board);
+        free(actual_board);
+    }
+
+    // The final comparison is not a part of the trace
+    if (result > trace->length)
+        result = trace->length;
+
+    gamma_delete(g);
+    free(o.board);
+    free(o.golden_used);
+    return result;
+}
+
+/** @brief Shrinks a failing game.
+ *
+ * Removes ever smaller chunks of the operations
+ * as long as the game still fails.
+ * @param trace         – the failing game, shrunk in place
+ */
+static void shrink(Trace *trace) {
+    trace->length = run(trace, false);
+
+    for (size_t chunk = trace->length / 2; chunk >= 1; chunk /= 2) {
+        size_t start = 0;
+        while (start + chunk <= trace->length) {
+            Trace smaller = *trace;
+            smaller.operations = malloc(trace->length * sizeof(Operation));
+            if (smaller.operations == NULL)
+                exit(1);
+            memcpy(smaller.operations, trace->operations,
+                   start * sizeof(Operation));
+            memcpy(smaller.operations + start,
+                   trace->operations + start + chunk,
+                   (trace->length - start - chunk) * sizeof(Operation));
+            smaller.length = trace->length - chunk;
+
+            size_t failed = run(&smaller, false);
+            if (failed > 0) {
+                free(trace->operations);
+                *trace = smaller;
+                trace->length = failed;
+            } else {
+                free(smaller.operations);
+                start += chunk;
+            }
+        }
+    }
+}
+
+/** @brief Prints a game as a batch mode input.
+ */
+static void print_trace(const Trace *trace) {
+    fprintf(stderr, "B %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+            trace->width, trace->height, trace->players, trace->areas);
+    for (size_t i = 0; i < trace->length; i++) {
+        const Operation *op = &trace->operations[i];
+        if (op->command == 'm' || op->command == 'g')
+            fprintf(stderr, "%c %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+                    op->command, op->player, op->x, op->y);
+        else if (op->command == 'p')
+            fprintf(stderr, "p\n");
+        else if (op->command == 'c')
+            fprintf(stderr, "c %" PRIu32 " 0 0 %" PRIu32 " %" PRIu32 "\n",
+                    op->player, trace->width + 1, trace->height + 1);
+        else if (op->command == 'k' || op->command == 'l')
+            fprintf(stderr, "# %c %" PRIu32 "\n", op->command, op->player);
+        else
+            fprintf(stderr, "%c %" PRIu32 "\n", op->command, op->player);
+    }
+    fprintf(stderr, "p\n");
+}
+
+/** @brief State of the pseudorandom generator (xorshift64*)
+ */
+static uint64_t seed = 1;
+
+/** @brief Returns a pseudorandom number from [0, @p bound).
+ */
+static uint64_t random_below(uint64_t bound) {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return (seed * UINT64_C(0x2545F4914F6CDD1D)) % bound;
+}
+
+/** @brief Ordinary moves of a tall board generated so far,
+ *         see @ref random_trace
+ */
+typedef struct Growth {
+    uint32_t *owners;    /**< Owner of the field (x, y) is
+                              owners[y * width + x], zero if free */
+    uint64_t *taken;     /**< Fields taken so far, in the order taken */
+    uint64_t count;      /**< Number of the fields taken so far */
+    uint32_t seeds[MAX_TALL_BOARD_PLAYERS + 1]; /**< Numbers of the areas
+                              started by each player */
+} Growth;
+
+/** @brief Records an ordinary move on a tall board.
+ *
+ * Assumes the move is legal if it takes a free field next to a field
+ * of the player or if the player has not started as many areas
+ * as the limit allows, ignoring the golden moves.
+ * @param trace         – the game being generated
+ * @param growth        – the moves generated so far
+ * @param op            – the move, on the board and of a valid player
+ */
+static void growth_take(const Trace *trace, Growth *growth,
+                        const Operation *op) {
+    uint32_t *owners = growth->owners;
+    uint64_t cell = (uint64_t) op->y * trace->width + op->x;
+    if (owners[cell] != 0)
+        return;
+
+    bool next_to_own = (op->x > 0 && owners[cell - 1] == op->player) ||
+                       (op->x + 1 < trace->width &&
+                        owners[cell + 1] == op->player) ||
+                       (op->y > 0 &&
+                        owners[cell - trace->width] == op->player) ||
+                       (op->y + 1 < trace->height &&
+                        owners[cell + trace->width] == op->player);
+    if (next_to_own || growth->seeds[op->player] < trace->areas) {
+        growth->seeds[op->player] += next_to_own ? 0 : 1;
+        owners[cell] = op->player;
+        growth->taken[growth->count++] = cell;
+    }
+}
+
+/** @brief Moves an operation next to a field of its player.
+ *
+ * Prefers the free fields neighbouring a field taken by the player,
+ * leaves the operation unchanged if it finds none soon.
+ * @param trace         – the game being generated
+ * @param growth        – the moves generated so far
+ * @param op            – the operation
+ */
+static void growth_place(const Trace *trace, Growth *growth, Operation *op) {
+    for (int attempt = 0; growth->count > 0 && attempt < 32; attempt++) {
+        uint64_t cell = growth->taken[random_below(growth->count)];
+        if (growth->owners[cell] != op->player)
+            continue;
+
+        uint32_t x = cell % trace->width, y = cell / trace->width;
+        switch (random_below(4)) {
+            case 0:
+                x += x + 1 < trace->width ? 1 : 0;
+                break;
+            case 1:
+                x -= x > 0 ? 1 : 0;
+                break;
+            case 2:
+                y += y + 1 < trace->height ? 1 : 0;
+                break;
+            default:
+                y -= y > 0 ? 1 : 0;
+        }
+        op->x = x;
+        op->y = y;
+        if (growth->owners[(uint64_t) y * trace->width + x] == 0)
+            return;
+    }
+}
+
+/** @brief Generates a random game.
+ *
+ * The players and the fields are occasionally invalid.
+ * @param trace         – where to store the game
+ */
+static void random_trace(Trace *trace) {
+    static const char all_commands[] = "mmmmmmmmmmggggbffqqrplkc";
+    // Without the queries the oracle answers in time quadratic in the board
+    static const char tall_commands[] = "mmmmmmmmmmggggbqqrpk";
+    const char *commands = all_commands;
+    size_t number_of_commands = sizeof(all_commands) - 1;
+    bool tall = false;
+    // Long enough to fill the board several times
+    size_t length = random_below(8 * MAX_BOARD_SIZE * MAX_BOARD_SIZE) + 1;
+
+    trace->width = random_below(MAX_BOARD_SIZE) + 1;
+    trace->height = random_below(MAX_BOARD_SIZE) + 1;
+    trace->players = random_below(MAX_PLAYERS) + 1;
+    // Exercise the rendering of long rows and of wide columns
+    if (random_below(8) == 0) {
+        trace->width = random_below(MAX_WIDE_BOARD_SIZE) + 1;
+        trace->height = random_below(2) + 1;
+    }
+    // Exercise the generic engine, the narrower boards have bitboards
+    if (random_below(8) == 0)
+        trace->width = BITBOARD_MAX_WIDTH + 1 + random_below(MAX_BOARD_SIZE);
+    if (random_below(8) == 0)
+        trace->players = random_below(MAX_MANY_PLAYERS) + 1;
+    // Exercise the 16 and 32 bit owners around their boundary
+    if (random_below(16) == 0)
+        trace->players = UINT16_MAX - MAX_MANY_PLAYERS +
+                         random_below(2 * MAX_MANY_PLAYERS);
+    trace->areas = random_below(MAX_AREAS) + 1;
+    // Exercise the areas of the generic engine crossing the boundaries
+    // of its blocks both horizontally and vertically
+    if (random_below(128) == 0) {
+        trace->width = BITBOARD_MAX_WIDTH + 1 +
+                       random_below(MAX_TALL_BOARD_WIDTH - BITBOARD_MAX_WIDTH);
+        trace->height = MIN_TALL_BOARD_HEIGHT +
+                        random_below(MAX_TALL_BOARD_HEIGHT -
+                                     MIN_TALL_BOARD_HEIGHT + 1);
+        trace->players = random_below(MAX_TALL_BOARD_PLAYERS - 1) + 2;
+        tall = true;
+        commands = tall_commands;
+        number_of_commands = sizeof(tall_commands) - 1;
+        uint64_t fields = (uint64_t) trace->width * trace->height;
+        length = fields + random_below(3 * fields);
+    }
+    trace->length = length;
+    trace->operations = malloc(length * sizeof(Operation));
+    if (trace->operations == NULL)
+        exit(1);
+
+    // On the tall boards the moves at random fields would mostly
+    // exceed the area limit, instead the players mostly play next to
+    // the fields they have taken before, growing their areas
+    Growth growth = {NULL, NULL, 0, {0}};
+    if (tall) {
+        uint64_t fields = (uint64_t) trace->width * trace->height;
+        growth.owners = calloc(fields, sizeof(uint32_t));
+        growth.taken = malloc(fields * sizeof(uint64_t));
+        if (growth.owners == NULL || growth.taken == NULL)
+            exit(1);
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        Operation *op = &trace->operations[i];
+        op->command = commands[random_below(number_of_commands)];
+        op->player = random_below(trace->players + 2);
+        op->x = random_below(trace->width + 1);
+        op->y = random_below(trace->height + 1);
+
+        if (tall && op->player >= 1 && op->player <= trace->players) {
+            growth_place(trace, &growth, op);
+            if (op->command == 'm' && op->x < trace->width &&
+                op->y < trace->height)
+                growth_take(trace, &growth, op);
+        }
+    }
+
+    free(growth.owners);
+    free(growth.taken);
+}
+
+/** @brief Plays random games until @p operations operations are done.
+ *
+ * @return 0 if the engine agrees with the oracle, 1 otherwise.
+ */
+int main(int argc, char *argv[]) {
+    uint64_t operations = 1000000;
+    if (argc > 1)
+        seed = strtoull(argv[1], NULL, 10) | 1;
+    if (argc > 2)
+        operations = strtoull(argv[2], NULL, 10);
+
+    for (uint64_t done = 0; done < operations;) {
+        Trace trace;
+        random_trace(&trace);
+
+        if (run(&trace, false) > 0) {
+            shrink(&trace);
+            fprintf(stderr, "The engine differs from the oracle "
+                            "after this input:\n");
+            print_trace(&trace);
+            run(&trace, true);
+            free(trace.operations);
+            return 1;
+        }
+
+        done += trace.length;
+        free(trace.operations);
+    }
+
+    printf("%" PRIu64 " operations agree with the oracle\n", operations);
+    return 0;
+}
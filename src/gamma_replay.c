@@ -0,0 +1,132 @@
+/** @file
+ * Replay driver for load testing the batch mode
+ *
+ * Reads a whole batch mode input (e.g. generated by gamma_gen),
+ * then executes its commands with @ref batch as fast as possible.
+ * The results of the commands are printed to the standard output
+ * like in the batch mode, the throughput is reported
+ * to the standard error output.
+ *
+ * Usage: gamma_replay input_file
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+#include "gamma.h"
+#include "batch.h"
+
+/** @brief Stores a single parsed command
+ */
+typedef struct Command {
+    char command;                      /**< One-letter command */
+    uint32_t args[MAX_NUMBER_OF_ARGS]; /**< Its arguments */
+    uint32_t number_of_args;           /**< Number of the arguments */
+} Command;
+
+/** @brief Returns the current time in nanoseconds.
+ */
+static uint64_t now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+/** @brief Parses a single line of the input with @ref parseCommand.
+ *
+ * @param line          – the line, without the newline character
+ * @param output        – where to store the command
+ * @return False if the line is not a command
+ *         (a comment, an empty or an invalid line), true otherwise.
+ */
+static bool parse_line(char *line, Command *output) {
+    return *line != '#' && parseCommand(line, &output->command, output->args,
+                                        &output->number_of_args);
+}
+
+/** @brief Reads all the commands of @p input.
+ *
+ * @param input         – the input
+ * @param count         – where to store the number of the commands
+ * @return Array of the commands or NULL if the allocation has failed.
+ */
+static Command *read_commands(FILE *input, size_t *count) {
+    size_t capacity = 1024;
+    Command *result = malloc(capacity * sizeof(Command));
+    char *line = NULL;
+    size_t length = 0;
+    ssize_t read;
+
+    *count = 0;
+    while (result != NULL && (read = getline(&line, &length, input)) != -1) {
+        if (read > 0 && line[read - 1] == '\n')
+            line[read - 1] = '\0';
+
+        if (*count == capacity) {
+            capacity *= 2;
+            Command *bigger = realloc(result, capacity * sizeof(Command));
+            if (bigger == NULL)
+                free(result);
+            result = bigger;
+        }
+
+        if (result != NULL && parse_line(line, &result[*count]))
+            (*count)++;
+    }
+
+    free(line);
+    return result;
+}
+
+/** @brief Replays the input and reports the throughput.
+ *
+ * @return 0 on success, 1 if the input could not be read
+ *         or does not start with a valid 'B' command.
+ */
+int main(int argc, char *argv[]) {
+    FILE *input = argc == 2 ? fopen(argv[1], "r") : NULL;
+    if (input == NULL) {
+        fprintf(stderr, "usage: %s input_file\n", argv[0]);
+        return 1;
+    }
+
+    size_t count;
+    Command *commands = read_commands(input, &count);
+    fclose(input);
+
+    gamma_t *g = NULL;
+    if (commands != NULL && count > 0 && commands[0].command == 'B' &&
+        commands[0].number_of_args == 4)
+        g = gamma_new(commands[0].args[0], commands[0].args[1],
+                      commands[0].args[2], commands[0].args[3]);
+    if (g == NULL) {
+        fprintf(stderr, "%s: the input does not start a batch mode game\n",
+                argv[0]);
+        free(commands);
+        return 1;
+    }
+
+    uint64_t errors = 0;
+    uint64_t start = now();
+    for (size_t i = 1; i < count; i++)
+        if (!batch(g, commands[i].command, commands[i].args,
+                   commands[i].number_of_args, stdout))
+            errors++;
+    fflush(stdout);
+    uint64_t elapsed = now() - start;
+
+    fprintf(stderr, "%zu commands (%" PRIu64 " invalid) in %.3f s: "
+                    "%.0f commands/s\n", count - 1, errors,
+            (double) elapsed / 1e9,
+            (double) (count - 1) / ((double) elapsed / 1e9));
+
+    gamma_delete(g);
+    free(commands);
+    return 0;
+}
@@ -0,0 +1,167 @@
+/** @file
+ * Test of the server mode through a Unix domain socket
+ *
+ * Starts the server in a child process, plays a game as its client
+ * and compares the answers with the expected ones, then stops
+ * the server with SIGTERM and checks that it has removed its socket.
+ *
+ * Usage: gamma_server_test [socket]
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "server.h"
+
+/** @brief Number of attempts to connect while the server is starting
+ */
+#define CONNECT_ATTEMPTS 500
+
+/** @brief Milliseconds between the attempts to connect
+ */
+#define CONNECT_RETRY_MS 10
+
+/** @brief Largest answer of the server read by the test
+ */
+#define MAX_ANSWER_LENGTH 4096
+
+/** @brief Input of the client, the last line without a newline
+ */
+static const char input[] =
+        "B 40000 40000 9 1\n"
+        "B 3 2 2 1\n"
+        "m 1 0 0\n"
+        "m 2 2 1\n"
+        "p\n"
+        "c 1 0 0 4000000000 4000000000\n"
+        "a 1 5000 1\n"
+        "# comment\n"
+        "x 1\n"
+        "m 1 1 0\n"
+        "q 2";
+
+/** @brief Answers of the server to @ref input
+ */
+static const char expected[] =
+        "ERROR 1\n"
+        "OK 2\n"
+        "1\n"
+        "1\n"
+        "..2\n"
+        "1..\n"
+        "100\n"
+        "010\n"
+        "ERROR 7\n"
+        "ERROR 9\n"
+        "1\n"
+        "1\n";
+
+/** @brief Connects to the server, waiting for it to start listening
+ * @param path          - path of the socket
+ * @return The socket or -1 if the server does not accept connections.
+ */
+static int connectTo(const char *path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    struct timespec retry = {0, CONNECT_RETRY_MS * 1000000L};
+
+    for (int attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++) {
+        int client = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (client < 0)
+            return -1;
+        if (connect(client, (struct sockaddr *) &address,
+                    sizeof(address)) == 0)
+            return client;
+        close(client);
+        if (errno != ENOENT && errno != ECONNREFUSED)
+            return -1;
+        nanosleep(&retry, NULL);
+    }
+    return -1;
+}
+
+/** @brief Sends the input and reads all the answers of the server
+ * @param client        - the socket connected to the server
+ * @param answer        - where to save the answers, at least
+ *                        MAX_ANSWER_LENGTH + 1 bytes
+ * @return false if the connection has failed, true otherwise
+ */
+static bool play(int client, char *answer) {
+    size_t sent = 0;
+    while (sent < sizeof(input) - 1) {
+        ssize_t length = send(client, input + sent, sizeof(input) - 1 - sent,
+                              MSG_NOSIGNAL);
+        if (length < 0 && errno != EINTR)
+            return false;
+        if (length > 0)
+            sent += length;
+    }
+    // The server answers the last line once the client closes its side
+    if (shutdown(client, SHUT_WR) != 0)
+        return false;
+
+    size_t received = 0;
+    while (received < MAX_ANSWER_LENGTH) {
+        ssize_t length = read(client, answer + received,
+                              MAX_ANSWER_LENGTH - received);
+        if (length == 0)
+            break;
+        if (length < 0 && errno != EINTR)
+            return false;
+        if (length > 0)
+            received += length;
+    }
+    answer[received] = '\0';
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "gamma_server_test.socket";
+
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0)
+        exit(server(path) ? 0 : 1);
+
+    char answer[MAX_ANSWER_LENGTH + 1];
+    int client = connectTo(path);
+    bool played = client >= 0 && play(client, answer);
+    if (client >= 0)
+        close(client);
+
+    int status;
+    kill(child, SIGTERM);
+    waitpid(child, &status, 0);
+
+    if (!played) {
+        fprintf(stderr, "Could not play with the server at %s\n", path);
+        return 1;
+    }
+    if (strcmp(answer, expected) != 0) {
+        fprintf(stderr, "The server has answered:\n%s"
+                        "instead of:\n%s", answer, expected);
+        return 1;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+        access(path, F_OK) == 0) {
+        fprintf(stderr, "The server has not stopped cleanly\n");
+        return 1;
+    }
+
+    printf("The server has answered correctly\n");
+    return 0;
+}
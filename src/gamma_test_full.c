@@ -8,8 +8,15 @@
 #undef NDEBUG
 #endif
 
+#include "batch.h"
+#include "pool.h"
+#include "trace.h"
+
 #include <assert.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
@@ -760,6 +767,906 @@ static int middle_board(void) {
     return PASS;
 }
 
+/* Wylicza ruchy gracza w porcjach po size ruchów. Sprawdza, czy każde pole
+ * pojawia się co najwyżej raz, i zwraca liczbę zwykłych i złotych ruchów. */
+static void count_legal_moves(gamma_t *g, uint32_t player, uint32_t size,
+                              uint64_t *normal, uint64_t *golden) {
+    bool seen[SMALL_BOARD_SIZE][SMALL_BOARD_SIZE][2] = {{{false}}};
+    LegalMove buffer[size];
+    uint32_t n;
+
+    LegalMoves moves = gamma_legal_moves(g, player);
+    assert(moves != NULL);
+
+    *normal = *golden = 0;
+    while ((n = gamma_legal_moves_next(moves, buffer, size)) > 0) {
+        assert(n <= size);
+        for (uint32_t i = 0; i < n; ++i) {
+            assert(buffer[i].x < SMALL_BOARD_SIZE);
+            assert(buffer[i].y < SMALL_BOARD_SIZE);
+            assert(!seen[buffer[i].x][buffer[i].y][buffer[i].golden]);
+            seen[buffer[i].x][buffer[i].y][buffer[i].golden] = true;
+            if (buffer[i].golden)
+                ++*golden;
+            else
+                ++*normal;
+        }
+    }
+    assert(gamma_legal_moves_next(moves, buffer, size) == 0);
+
+    gamma_legal_moves_delete(moves);
+}
+
+/* Testuje wyliczanie dozwolonych ruchów. */
+static int legal_moves(void) {
+    uint64_t normal, golden;
+
+    gamma_t *g = gamma_new(5, 5, 2, 2);
+    assert(g != NULL);
+
+    assert(gamma_legal_moves(NULL, 1) == NULL);
+    assert(gamma_legal_moves(g, 0) == NULL);
+    assert(gamma_legal_moves(g, 3) == NULL);
+
+    count_legal_moves(g, 1, 1, &normal, &golden);
+    assert(normal == 25 && golden == 0);
+
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 2, 3, 3));
+    assert(gamma_move(g, 2, 2, 1));
+
+    count_legal_moves(g, 1, 5, &normal, &golden);
+    assert(normal == gamma_free_fields(g, 1) && normal == 21);
+    assert(golden == 2);
+
+    // Gracz 1 osiąga limit obszarów.
+    assert(gamma_move(g, 1, 4, 0));
+    count_legal_moves(g, 1, 3, &normal, &golden);
+    assert(normal == gamma_free_fields(g, 1) && normal == 5);
+    assert(golden == 0);
+
+    // Gracz 2 też jest na limicie i nie sąsiaduje z polami gracza 1.
+    count_legal_moves(g, 2, 100, &normal, &golden);
+    assert(normal == gamma_free_fields(g, 2) && normal == 8);
+    assert(golden == 0);
+    assert(!gamma_golden_move(g, 2, 1, 0));
+
+    gamma_delete(g);
+
+    // Pole gracza 2 sąsiaduje z oboma obszarami gracza 1 na limicie.
+    g = gamma_new(5, 5, 2, 2);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 2, 1, 0));
+    assert(gamma_move(g, 1, 2, 0));
+
+    count_legal_moves(g, 1, 4, &normal, &golden);
+    assert(normal == gamma_free_fields(g, 1) && normal == 3);
+    assert(golden == 1);
+    count_legal_moves(g, 2, 4, &normal, &golden);
+    assert(normal == gamma_free_fields(g, 2) && normal == 22);
+    assert(golden == 2);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+/* Sprawdza, czy gracz na limicie obszarów może postawić pionek dokładnie
+ * na wolnych polach sąsiadujących z jego polami, czyli na polach jego
+ * zbioru pól granicznych, z którego czytane są te ruchy. */
+static void check_frontier(gamma_t *g, uint32_t player,
+                           uint32_t width, uint32_t height) {
+    bool expected[SMALL_BOARD_SIZE][SMALL_BOARD_SIZE] = {{false}};
+    uint64_t count = 0;
+    char *board = gamma_board(g);
+    assert(board != NULL);
+
+    // Wiersz y planszy jest wypisywany jako height - 1 - y.
+    #define OWNER(x, y) board[(height - 1 - (y)) * (width + 1) + (x)]
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            char mine = '0' + player;
+            if (OWNER(x, y) == '.' &&
+                ((x > 0 && OWNER(x - 1, y) == mine) ||
+                 (x + 1 < width && OWNER(x + 1, y) == mine) ||
+                 (y > 0 && OWNER(x, y - 1) == mine) ||
+                 (y + 1 < height && OWNER(x, y + 1) == mine))) {
+                expected[x][y] = true;
+                ++count;
+            }
+        }
+    }
+    #undef OWNER
+    free(board);
+
+    assert(gamma_free_fields(g, player) == count);
+
+    LegalMove buffer[4];
+    uint32_t n;
+    uint64_t normal = 0;
+    LegalMoves moves = gamma_legal_moves(g, player);
+    assert(moves != NULL);
+    while ((n = gamma_legal_moves_next(moves, buffer, SIZE(buffer))) > 0) {
+        for (uint32_t i = 0; i < n; ++i) {
+            if (!buffer[i].golden) {
+                assert(expected[buffer[i].x][buffer[i].y]);
+                expected[buffer[i].x][buffer[i].y] = false;
+                ++normal;
+            }
+        }
+    }
+    gamma_legal_moves_delete(moves);
+    assert(normal == count);
+}
+
+/* Testuje zbiory pól granicznych graczy po ruchach, złotych ruchach
+ * i ruchach odrzuconych z powodu limitu obszarów. */
+static int frontier(void) {
+    gamma_t *g = gamma_new(5, 5, 3, 1);
+    assert(g != NULL);
+
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 2, 4, 4));
+    assert(gamma_move(g, 3, 2, 2));
+    for (uint32_t player = 1; player <= 3; ++player)
+        check_frontier(g, player, 5, 5);
+
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_move(g, 2, 4, 3));
+    assert(gamma_move(g, 2, 3, 4));
+    assert(gamma_move(g, 3, 2, 1));
+    assert(gamma_move(g, 3, 2, 3));
+    for (uint32_t player = 1; player <= 3; ++player)
+        check_frontier(g, player, 5, 5);
+
+    // Gracze są na limicie obszarów.
+    assert(!gamma_move(g, 1, 3, 3));
+    assert(!gamma_move(g, 2, 0, 4));
+    assert(!gamma_golden_move(g, 1, 2, 1));
+    assert(!gamma_golden_move(g, 1, 2, 2));
+    for (uint32_t player = 1; player <= 3; ++player)
+        check_frontier(g, player, 5, 5);
+    assert(gamma_free_fields(g, 1) == 3);
+
+    // Złoty ruch zabiera graczowi 3 koniec jego obszaru.
+    assert(gamma_move(g, 1, 2, 0));
+    assert(gamma_golden_move(g, 1, 2, 1));
+    for (uint32_t player = 1; player <= 3; ++player)
+        check_frontier(g, player, 5, 5);
+    assert(gamma_free_fields(g, 1) == 4);
+    assert(gamma_free_fields(g, 3) == 5);
+
+    // Gracz 2 zabiera pole sąsiadujące z polami obu pozostałych graczy.
+    assert(gamma_move(g, 2, 2, 4));
+    assert(gamma_golden_move(g, 2, 2, 3));
+    for (uint32_t player = 1; player <= 3; ++player)
+        check_frontier(g, player, 5, 5);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+/* Testuje rozgałęzianie gry. */
+static int fork_game(void) {
+    static const char board_before[] =
+            "..2\n"
+            ".12\n"
+            "1..\n";
+    static const char board_after[] =
+            "2.2\n"
+            ".11\n"
+            "1.1\n";
+
+    assert(gamma_fork(NULL) == NULL);
+
+    gamma_t *g = gamma_new(3, 3, 2, 2);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 1, 1));
+    assert(gamma_move(g, 2, 2, 1));
+    assert(gamma_move(g, 2, 2, 2));
+
+    gamma_t *f = gamma_fork(g);
+    assert(f != NULL);
+    assert(gamma_golden_move(f, 1, 2, 1));
+    assert(gamma_move(f, 1, 2, 0));
+    assert(gamma_move(f, 2, 0, 2));
+    assert(!gamma_move(f, 2, 1, 0));
+
+    char *p = gamma_board(g);
+    assert(p != NULL);
+    assert(strcmp(p, board_before) == 0);
+    free(p);
+    assert(gamma_busy_fields(g, 1) == 2);
+    assert(gamma_free_fields(g, 1) == 3);
+    assert(gamma_golden_possible(g, 1));
+
+    // Rozgałęzienie przeżywa usunięcie gry, z której powstało.
+    gamma_delete(g);
+    p = gamma_board(f);
+    assert(p != NULL);
+    assert(strcmp(p, board_after) == 0);
+    free(p);
+    assert(gamma_busy_fields(f, 1) == 4);
+    assert(gamma_busy_fields(f, 2) == 2);
+    assert(!gamma_golden_possible(f, 1));
+
+    gamma_delete(f);
+    return PASS;
+}
+
+/* Testuje haszowanie stanu gry. */
+static int hash(void) {
+    assert(gamma_hash(NULL) == 0);
+
+    gamma_t *g1 = gamma_new(4, 4, 2, 2);
+    gamma_t *g2 = gamma_new(4, 4, 2, 2);
+    assert(g1 != NULL && g2 != NULL);
+    assert(gamma_hash(g1) == gamma_hash(g2));
+
+    // Ten sam stan osiągnięty w innej kolejności ruchów.
+    assert(gamma_move(g1, 1, 0, 0));
+    assert(gamma_move(g1, 2, 3, 3));
+    assert(gamma_move(g1, 1, 1, 0));
+    assert(gamma_move(g2, 1, 1, 0));
+    assert(gamma_move(g2, 1, 0, 0));
+    uint64_t before = gamma_hash(g2);
+    assert(gamma_move(g2, 2, 3, 3));
+    assert(gamma_hash(g2) != before);
+    assert(gamma_hash(g1) == gamma_hash(g2));
+
+    // Nieudane ruchy nie zmieniają haszu.
+    assert(!gamma_move(g1, 1, 0, 0));
+    assert(!gamma_golden_move(g1, 2, 2, 2));
+    assert(gamma_hash(g1) == gamma_hash(g2));
+
+    // Ta sama plansza, ale gracz 2 wykorzystał złoty ruch.
+    assert(gamma_move(g1, 2, 1, 1));
+    assert(gamma_move(g2, 1, 1, 1));
+    assert(gamma_golden_move(g2, 2, 1, 1));
+    assert(gamma_hash(g1) != gamma_hash(g2));
+
+    gamma_t *f = gamma_fork(g2);
+    assert(f != NULL);
+    assert(gamma_hash(f) == gamma_hash(g2));
+    assert(gamma_move(f, 1, 2, 0));
+    assert(gamma_hash(f) != gamma_hash(g2));
+
+    gamma_delete(f);
+    gamma_delete(g1);
+    gamma_delete(g2);
+    return PASS;
+}
+
+/* Testuje liczniki pracy silnika. */
+static int stats(void) {
+    GammaStats stats;
+    assert(!gamma_stats(NULL, &stats));
+
+    gamma_t *g = gamma_new(3, 3, 2, 2);
+    assert(g != NULL);
+    assert(!gamma_stats(g, NULL));
+
+    // Bez GAMMA_STATS liczniki nie są dostępne.
+    if (!gamma_stats(g, &stats)) {
+        gamma_delete(g);
+        return PASS;
+    }
+    assert(stats.bfs_runs == 0 && stats.owner_changes == 0);
+
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 1, 1, 0));
+    assert(gamma_stats(g, &stats));
+    assert(stats.trial_validations == 2);
+    // Walidacja nie zmienia właściciela, a ruch zmienia go raz.
+    assert(stats.owner_changes == 2);
+    // Zwykłe ruchy nie przeszukują planszy.
+    assert(stats.bfs_runs == 0);
+
+    // Złoty ruch rozcina obszar gracza 1 na dwa.
+    assert(gamma_move(g, 1, 0, 1));
+    assert(gamma_golden_move(g, 2, 0, 0));
+    assert(gamma_stats(g, &stats));
+    assert(stats.trial_validations == 4);
+    assert(stats.owner_changes == 4);
+    assert(stats.bfs_runs > 0);
+    assert(stats.cells_visited > 0);
+    // Wąska plansza jest przeszukiwana całymi wierszami, bez kolejki.
+    assert(stats.queue_pushes == 0);
+
+    char *p = gamma_board(g);
+    assert(p != NULL);
+    assert(gamma_stats(g, &stats));
+    assert(stats.bytes_rendered == strlen(p));
+    free(p);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+/* Kolejne kroki wątku z testu trace_sessions. */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    int step;
+} TraceSteps;
+
+static void wait_for_step(TraceSteps *steps, int step) {
+    pthread_mutex_lock(&steps->mutex);
+    while (steps->step < step)
+        pthread_cond_wait(&steps->changed, &steps->mutex);
+    pthread_mutex_unlock(&steps->mutex);
+}
+
+static void next_step(TraceSteps *steps) {
+    pthread_mutex_lock(&steps->mutex);
+    ++steps->step;
+    pthread_cond_broadcast(&steps->changed);
+    pthread_mutex_unlock(&steps->mutex);
+}
+
+/* Wykonuje ruch w każdej z dwóch sesji śledzenia. */
+static void *trace_in_sessions(void *arg) {
+    TraceSteps *steps = arg;
+    gamma_t *g = gamma_new(3, 3, 2, 1);
+    if (g == NULL)
+        return NULL;
+
+    wait_for_step(steps, 1);
+    bool moved = gamma_move(g, 1, 0, 0);
+    next_step(steps);
+    wait_for_step(steps, 3);
+    moved = moved && gamma_move(g, 2, 2, 2);
+    next_step(steps);
+
+    gamma_delete(g);
+    return moved ? arg : NULL;
+}
+
+/* Testuje śledzenie wątku żyjącego dłużej niż sesja śledzenia. */
+static int trace_sessions(void) {
+    static const char path[] = "trace_sessions.json";
+    TraceSteps steps = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0};
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, trace_in_sessions, &steps) == 0);
+
+    assert(trace_start(path));
+    next_step(&steps);
+    wait_for_step(&steps, 2);
+    trace_stop();
+
+    // Bufor wątku z poprzedniej sesji został zwolniony.
+    assert(trace_start(path));
+    next_step(&steps);
+    wait_for_step(&steps, 4);
+    trace_stop();
+
+    void *result;
+    assert(pthread_join(thread, &result) == 0);
+    assert(result != NULL);
+
+    char trace[4096];
+    FILE *file = fopen(path, "r");
+    assert(file != NULL);
+    size_t length = fread(trace, 1, sizeof(trace) - 1, file);
+    fclose(file);
+    remove(path);
+    trace[length] = '\0';
+    assert(strstr(trace, "\"gamma_move\"") != NULL);
+
+    return PASS;
+}
+
+/* Wykonuje polecenie trybu wsadowego i zapisuje jego wynik w out. */
+static bool batch_output(gamma_t *g, char command, uint32_t *args,
+                         uint32_t count, char *out, size_t size) {
+    FILE *file = tmpfile();
+    assert(file != NULL);
+    bool result = batch(g, command, args, count, file);
+    rewind(file);
+    size_t length = fread(out, 1, size - 1, file);
+    out[length] = '\0';
+    fclose(file);
+    return result;
+}
+
+/* Testuje rejestr obszarów graczy. */
+static int area_registry(void) {
+    GammaArea area;
+    uint32_t ids[4];
+    assert(gamma_area_id(NULL, 0, 0) == 0);
+    assert(!gamma_area(NULL, 1, &area));
+    assert(gamma_player_areas(NULL, 1, ids, 4) == 0);
+    assert(gamma_largest_area(NULL, 1) == 0);
+
+    gamma_t *g = gamma_new(5, 5, 2, 3);
+    assert(g != NULL);
+    assert(gamma_player_areas(g, 0, ids, 4) == 0);
+    assert(gamma_player_areas(g, 1, ids, 4) == 0);
+    assert(gamma_largest_area(g, 1) == 0);
+    assert(gamma_area_id(g, 0, 0) == 0);
+    assert(!gamma_area(g, 0, &area));
+    assert(!gamma_area(g, 1, &area));
+
+    // Dwa obszary gracza 1 łączą się w jeden, zostaje jeden z numerów.
+    assert(gamma_move(g, 1, 0, 2));
+    assert(gamma_move(g, 1, 2, 2));
+    assert(gamma_player_areas(g, 1, ids, 4) == 2);
+    uint32_t a = gamma_area_id(g, 0, 2), b = gamma_area_id(g, 2, 2);
+    assert(a != 0 && b != 0 && a != b);
+    assert(gamma_move(g, 1, 1, 2));
+    assert(gamma_player_areas(g, 1, ids, 4) == 1);
+    assert(gamma_area(g, a, &area) != gamma_area(g, b, &area));
+    assert(gamma_area(g, ids[0], &area));
+    assert(area.player == 1 && area.size == 3);
+    assert(area.min_x == 0 && area.max_x == 2);
+    assert(area.min_y == 2 && area.max_y == 2);
+    assert(gamma_area_id(g, 0, 2) == ids[0]);
+    assert(gamma_area_id(g, 2, 2) == ids[0]);
+    assert(gamma_area_id(g, 5, 2) == 0);
+
+    assert(gamma_move(g, 1, 1, 3));
+    assert(gamma_move(g, 1, 1, 4));
+    assert(gamma_largest_area(g, 1) == 5);
+
+    // Złoty ruch rozcina obszar na trzy, największy zachowuje numer.
+    uint32_t id = ids[0];
+    assert(gamma_golden_move(g, 2, 1, 2));
+    assert(gamma_player_areas(g, 1, ids, 4) == 3);
+    assert(gamma_area(g, id, &area));
+    assert(area.player == 1 && area.size == 2);
+    assert(area.min_x == 1 && area.max_x == 1);
+    assert(area.min_y == 3 && area.max_y == 4);
+    assert(gamma_largest_area(g, 1) == 2);
+    assert(gamma_area_id(g, 0, 2) != gamma_area_id(g, 2, 2));
+    assert(gamma_area(g, gamma_area_id(g, 1, 2), &area));
+    assert(area.player == 2 && area.size == 1);
+
+    // Rozgałęzienie ma własny rejestr.
+    gamma_t *f = gamma_fork(g);
+    assert(f != NULL);
+    assert(gamma_move(f, 1, 0, 3));
+    assert(gamma_player_areas(f, 1, NULL, 0) == 2);
+    assert(gamma_largest_area(f, 1) == 4);
+    assert(gamma_player_areas(g, 1, NULL, 0) == 3);
+    assert(gamma_largest_area(g, 1) == 2);
+
+    // Polecenie r trybu wsadowego, też dla gracza bez obszarów.
+    char out[64], expected[64];
+    uint32_t player = 2;
+    assert(batch_output(f, 'r', &player, 1, out, sizeof(out)));
+    sprintf(expected, "1\n%u 1 1 2 1 2\n", gamma_area_id(f, 1, 2));
+    assert(strcmp(out, expected) == 0);
+    gamma_delete(f);
+    gamma_t *empty = gamma_new(5, 5, 2, 3);
+    assert(empty != NULL);
+    assert(batch_output(empty, 'r', &player, 1, out, sizeof(out)));
+    assert(strcmp(out, "0\n") == 0);
+    gamma_delete(empty);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+/* Testuje złote ruchy na planszy dzielonej na bloki. */
+static int block_connectivity(void) {
+    // Plansza jest zbyt szeroka na maski wierszy.
+    gamma_t *g = gamma_new(100, 100, 4, 2);
+    assert(g != NULL);
+
+    // Pierścień gracza 1 przecina krawędzie wielu bloków.
+    for (uint32_t x = 10; x < 80; ++x)
+        assert(gamma_move(g, 1, x, 10));
+    for (uint32_t y = 10; y < 80; ++y)
+        assert(gamma_move(g, 1, 80, y));
+    for (uint32_t x = 80; x > 10; --x)
+        assert(gamma_move(g, 1, x, 80));
+    for (uint32_t y = 80; y > 10; --y)
+        assert(gamma_move(g, 1, 10, y));
+    assert(gamma_busy_fields(g, 1) == 280);
+
+    // Pierścień po rozcięciu pozostaje jednym obszarem.
+    assert(gamma_golden_move(g, 2, 10, 50));
+    assert(gamma_largest_area(g, 1) == 279);
+    // Drugie rozcięcie daje dwa obszary.
+    assert(gamma_golden_move(g, 3, 80, 50));
+    assert(gamma_player_areas(g, 1, NULL, 0) == 2);
+    // Trzecie przekroczyłoby limit.
+    assert(!gamma_golden_move(g, 4, 63, 10));
+
+    // Obejście pola zmienia bloki, które przeszukiwanie już zna.
+    assert(gamma_move(g, 1, 63, 9));
+    assert(gamma_move(g, 1, 62, 9));
+    assert(gamma_move(g, 1, 64, 9));
+    assert(gamma_golden_move(g, 4, 63, 10));
+    assert(gamma_player_areas(g, 1, NULL, 0) == 2);
+
+    gamma_delete(g);
+    return PASS;
+}
+
+/* Wynik wyliczenia ruchów gracza przez jeden wątek. */
+typedef struct {
+    gamma_t *g;
+    uint32_t player;
+    uint64_t normal, golden, checksum, free_fields;
+} MovesSummary;
+
+/* Wylicza ruchy gracza, nie zmieniając stanu gry. */
+static void *summarize_moves(void *arg) {
+    MovesSummary *summary = arg;
+    LegalMove buffer[64];
+    uint32_t n;
+
+    summary->normal = summary->golden = summary->checksum = 0;
+    summary->free_fields = gamma_free_fields(summary->g, summary->player);
+    LegalMoves moves = gamma_legal_moves(summary->g, summary->player);
+    if (moves == NULL)
+        return NULL;
+    while ((n = gamma_legal_moves_next(moves, buffer, SIZE(buffer))) > 0) {
+        for (uint32_t i = 0; i < n; ++i) {
+            if (buffer[i].golden)
+                ++summary->golden;
+            else
+                ++summary->normal;
+            summary->checksum += ((uint64_t) buffer[i].x * 1000003 +
+                                  buffer[i].y) * 2 + buffer[i].golden;
+        }
+    }
+    gamma_legal_moves_delete(moves);
+    return summary;
+}
+
+/* Testuje wyliczanie ruchów tej samej gry przez wiele wątków naraz. */
+static int concurrent_readers(void) {
+    // Gracze są na limicie obszarów, więc złote ruchy wymagają
+    // sprawdzenia spójności, na maskach wierszy albo na blokach.
+    static const uint32_t sizes[][3] = {{40, 30, 100}, {100, 70, 400}};
+    enum { PLAYERS = 3, THREADS = 8 };
+
+    for (size_t k = 0; k < SIZE(sizes); ++k) {
+        gamma_t *g = gamma_new(sizes[k][0], sizes[k][1], PLAYERS, sizes[k][2]);
+        assert(g != NULL);
+
+        uint64_t seed = 42;
+        for (uint32_t i = 0; i < sizes[k][0] * sizes[k][1] / 2; ++i) {
+            seed = seed * 6364136223846793005u + 1442695040888963407u;
+            gamma_move(g, i % PLAYERS + 1, (seed >> 33) % sizes[k][0],
+                       (seed >> 13) % sizes[k][1]);
+        }
+
+        MovesSummary expected[PLAYERS];
+        for (uint32_t p = 0; p < PLAYERS; ++p) {
+            expected[p] = (MovesSummary) {.g = g, .player = p + 1};
+            assert(summarize_moves(&expected[p]) != NULL);
+            assert(expected[p].normal == expected[p].free_fields);
+            assert(expected[p].golden > 0);
+        }
+
+        pthread_t threads[THREADS];
+        MovesSummary summaries[THREADS];
+        for (uint32_t t = 0; t < THREADS; ++t) {
+            summaries[t] = (MovesSummary) {.g = g, .player = t % PLAYERS + 1};
+            assert(pthread_create(&threads[t], NULL, summarize_moves,
+                                  &summaries[t]) == 0);
+        }
+        for (uint32_t t = 0; t < THREADS; ++t) {
+            void *result;
+            assert(pthread_join(threads[t], &result) == 0);
+            assert(result != NULL);
+            MovesSummary *e = &expected[t % PLAYERS];
+            assert(summaries[t].normal == e->normal);
+            assert(summaries[t].golden == e->golden);
+            assert(summaries[t].checksum == e->checksum);
+            assert(summaries[t].free_fields == e->free_fields);
+        }
+
+        gamma_delete(g);
+    }
+    return PASS;
+}
+
+/* Czytelnik stanów gry opublikowanych przez inny wątek. */
+typedef struct {
+    Snapshots snapshots;
+    atomic_bool *finished;
+    uint32_t players;
+    uint64_t reads;
+} SnapshotsReading;
+
+/* Sprawdza, czy każdy przypięty stan jest spójny i nie cofa się. */
+static void *read_snapshots(void *arg) {
+    SnapshotsReading *reading = arg;
+    SnapshotReader reader = gamma_snapshot_reader_new(reading->snapshots);
+    if (reader == NULL)
+        return NULL;
+
+    uint64_t last_busy = 0;
+    bool finished;
+    do {
+        finished = atomic_load(reading->finished);
+        gamma_t *g = gamma_snapshot_pin(reader);
+        uint64_t busy = 0, free_fields = 0;
+        for (uint32_t p = 1; p <= reading->players; ++p) {
+            busy += gamma_busy_fields(g, p);
+            free_fields += gamma_free_fields(g, p);
+        }
+        char *board = gamma_board(g);
+        gamma_snapshot_unpin(reader);
+        if (board == NULL)
+            return NULL;
+
+        uint64_t pawns = 0;
+        for (char *c = board; *c != '\0'; ++c)
+            pawns += *c != '.' && *c != '\n';
+        free(board);
+        if (pawns != busy || busy < last_busy || free_fields == 0)
+            return NULL;
+        last_busy = busy;
+        ++reading->reads;
+    } while (!finished);
+
+    gamma_snapshot_reader_delete(reader);
+    return reading;
+}
+
+/* Testuje czytanie gry przez wiele wątków w trakcie rozgrywki. */
+static int snapshots(void) {
+    enum { PLAYERS = 3, READERS = 4 };
+    static const uint32_t sizes[][2] = {{30, 30}, {100, 100}};
+
+    assert(gamma_snapshots_new(NULL) == NULL);
+    assert(gamma_snapshot_reader_new(NULL) == NULL);
+    gamma_snapshots_delete(NULL);
+    gamma_snapshot_reader_delete(NULL);
+
+    for (size_t k = 0; k < SIZE(sizes); ++k) {
+        gamma_t *g = gamma_new(sizes[k][0], sizes[k][1], PLAYERS, 1000);
+        assert(g != NULL);
+        Snapshots snapshots = gamma_snapshots_new(g);
+        assert(snapshots != NULL);
+
+        atomic_bool finished = false;
+        pthread_t threads[READERS];
+        SnapshotsReading readings[READERS];
+        for (uint32_t t = 0; t < READERS; ++t) {
+            readings[t] = (SnapshotsReading) {snapshots, &finished,
+                                              PLAYERS, 0};
+            assert(pthread_create(&threads[t], NULL, read_snapshots,
+                                  &readings[t]) == 0);
+        }
+
+        uint64_t seed = 7;
+        for (uint32_t i = 0; i < 2000; ++i) {
+            seed = seed * 6364136223846793005u + 1442695040888963407u;
+            uint32_t player = i % PLAYERS + 1;
+            uint32_t x = (seed >> 33) % sizes[k][0];
+            uint32_t y = (seed >> 13) % sizes[k][1];
+            if (gamma_move(g, player, x, y) ||
+                gamma_golden_move(g, player, x, y))
+                assert(gamma_snapshots_publish(snapshots));
+        }
+        atomic_store(&finished, true);
+
+        for (uint32_t t = 0; t < READERS; ++t) {
+            void *result;
+            assert(pthread_join(threads[t], &result) == 0);
+            assert(result != NULL);
+            assert(readings[t].reads > 0);
+        }
+
+        // Zwolniony czytelnik jest używany ponownie.
+        SnapshotReader reader = gamma_snapshot_reader_new(snapshots);
+        assert(reader != NULL);
+        gamma_t *last = gamma_snapshot_pin(reader);
+        assert(gamma_hash(last) == gamma_hash(g));
+        for (uint32_t p = 1; p <= PLAYERS; ++p)
+            assert(gamma_busy_fields(last, p) == gamma_busy_fields(g, p));
+        gamma_snapshot_reader_delete(reader);
+
+        gamma_snapshots_delete(snapshots);
+        gamma_delete(g);
+    }
+    return PASS;
+}
+
+/* Testuje wypisywanie planszy przez wiele wątków. */
+static int parallel_board(void) {
+    // Kolumny szerokości 1, 2, 3 i 4 znaków.
+    static const uint32_t players[] = {5, 50, 500, 5000};
+
+    assert(!gamma_set_threads(NULL, 2));
+
+    for (size_t k = 0; k < SIZE(players); ++k) {
+        gamma_t *g = gamma_new(400, 500, players[k], 1000000);
+        assert(g != NULL);
+        assert(!gamma_set_threads(g, 0));
+
+        uint64_t seed = 3;
+        for (uint32_t i = 0; i < 40000; ++i) {
+            seed = seed * 6364136223846793005u + 1442695040888963407u;
+            gamma_move(g, (seed >> 40) % players[k] + 1, (seed >> 20) % 400,
+                       (seed >> 3) % 500);
+        }
+
+        char *expected = gamma_board(g);
+        assert(expected != NULL);
+        for (uint32_t threads = 2; threads <= 8; threads *= 2) {
+            assert(gamma_set_threads(g, threads));
+            char *board = gamma_board(g);
+            assert(board != NULL);
+            assert(strcmp(board, expected) == 0);
+            free(board);
+
+            // Kopia gry wypisuje planszę tyloma samymi wątkami.
+            gamma_t *fork = gamma_fork(g);
+            assert(fork != NULL);
+            board = gamma_board(fork);
+            assert(board != NULL);
+            assert(strcmp(board, expected) == 0);
+            free(board);
+            gamma_delete(fork);
+        }
+
+        // Pula ma nie więcej wątków niż procesorów i startuje ponownie
+        // po zatrzymaniu.
+        assert(gamma_set_threads(g, 100000));
+        for (int round = 0; round < 2; ++round) {
+            char *board = gamma_board(g);
+            assert(board != NULL);
+            assert(strcmp(board, expected) == 0);
+            free(board);
+            pool_shutdown();
+        }
+        free(expected);
+        gamma_delete(g);
+    }
+    return PASS;
+}
+
+/* Testuje sprawdzanie wielu ruchów naraz. */
+static int check_moves(void) {
+    static const uint32_t sizes[][3] = {{40, 30, 20}, {100, 70, 100}};
+    LegalMove move = {0, 0, false};
+    bool result;
+
+    for (size_t k = 0; k < SIZE(sizes); ++k) {
+        uint32_t width = sizes[k][0], height = sizes[k][1];
+        gamma_t *g = gamma_new(width, height, 3, sizes[k][2]);
+        assert(g != NULL);
+
+        assert(!gamma_check_moves(NULL, 1, &move, 1, &result, 1));
+        assert(!gamma_check_moves(g, 0, &move, 1, &result, 1));
+        assert(!gamma_check_moves(g, 4, &move, 1, &result, 1));
+        assert(!gamma_check_moves(g, 1, NULL, 1, &result, 1));
+        assert(!gamma_check_moves(g, 1, &move, 1, NULL, 1));
+        assert(!gamma_check_moves(g, 1, &move, 1, &result, 0));
+        assert(gamma_check_moves(g, 1, NULL, 0, NULL, 1));
+
+        uint64_t seed = 11;
+        for (uint32_t i = 0; i < width * height / 2; ++i) {
+            seed = seed * 6364136223846793005u + 1442695040888963407u;
+            gamma_move(g, i % 3 + 1, (seed >> 33) % width,
+                       (seed >> 13) % height);
+        }
+        // Gracz 3 wykorzystuje złoty ruch.
+        bool golden = false;
+        for (uint32_t i = 0; i < width * height && !golden; ++i)
+            golden = gamma_golden_move(g, 3, i % width, i / width);
+        assert(golden);
+
+        // Każde pole planszy i pola tuż za nią, oba rodzaje ruchów.
+        uint64_t count = 2 * (uint64_t) (width + 1) * (height + 1);
+        LegalMove *moves = malloc(count * sizeof(LegalMove));
+        bool *results = malloc(count * sizeof(bool));
+        assert(moves != NULL && results != NULL);
+        for (uint64_t i = 0; i < count; ++i) {
+            moves[i].x = (i / 2) % (width + 1);
+            moves[i].y = (i / 2) / (width + 1);
+            moves[i].golden = i % 2;
+        }
+
+        for (uint32_t player = 1; player <= 3; ++player) {
+            for (uint32_t threads = 1; threads <= 4; threads *= 2) {
+                memset(results, 0, count * sizeof(bool));
+                assert(gamma_check_moves(g, player, moves, count, results,
+                                         threads));
+
+                uint64_t legal = 0;
+                for (uint64_t i = 0; i < count; ++i) {
+                    gamma_t *fork = gamma_fork(g);
+                    assert(fork != NULL);
+                    if (moves[i].golden)
+                        assert(results[i] == gamma_golden_move(
+                                fork, player, moves[i].x, moves[i].y));
+                    else
+                        assert(results[i] == gamma_move(
+                                fork, player, moves[i].x, moves[i].y));
+                    gamma_delete(fork);
+                    legal += results[i];
+                }
+                assert(legal > 0);
+            }
+        }
+
+        free(moves);
+        free(results);
+        gamma_delete(g);
+    }
+    return PASS;
+}
+
+/* Wykonuje polecenie c trybu wsadowego i zapisuje jego wynik w out. */
+static bool batch_rectangle(gamma_t *g, uint32_t player, uint32_t x,
+                            uint32_t y, uint32_t width, uint32_t height,
+                            char *out, size_t size) {
+    uint32_t args[] = {player, x, y, width, height};
+    return batch_output(g, 'c', args, SIZE(args), out, size);
+}
+
+/* Testuje polecenie c trybu wsadowego, też z prostokątem większym
+ * niż plansza, którego liczba pól nie mieści się w 64 bitach. */
+static int check_rectangle(void) {
+    static char out[256];
+    gamma_t *g = gamma_new(10, 10, 2, 2);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 2, 2, 0));
+    assert(gamma_move(g, 1, 5, 5));
+
+    assert(batch_rectangle(g, 2, 0, 0, 3, 2, out, sizeof(out)));
+    assert(strcmp(out, "111\n110\n") == 0);
+    assert(batch_rectangle(g, 1, 4, 4, 3, 3, out, sizeof(out)));
+    assert(strcmp(out, "010\n101\n010\n") == 0);
+
+    // Część prostokąta poza planszą jest pomijana.
+    assert(batch_rectangle(g, 2, 8, 9, 5, 5, out, sizeof(out)));
+    assert(strcmp(out, "11\n") == 0);
+    assert(batch_rectangle(g, 1, 0, 0, 4294836226u, 2147549185u,
+                         out, sizeof(out)));
+    assert(strlen(out) == 10 * 11);
+    assert(batch_rectangle(g, 2, 0, 0, UINT32_MAX, UINT32_MAX,
+                         out, sizeof(out)));
+    assert(strlen(out) == 10 * 11);
+
+    assert(!batch_rectangle(g, 1, 10, 0, 1, 1, out, sizeof(out)));
+    assert(!batch_rectangle(g, 1, 0, 10, 1, 1, out, sizeof(out)));
+    assert(!batch_rectangle(g, 1, 0, 0, 0, 1, out, sizeof(out)));
+    assert(!batch_rectangle(g, 3, 0, 0, 1, 1, out, sizeof(out)));
+
+    gamma_delete(g);
+    return PASS;
+}
+
+/* Testuje gracza komputerowego. */
+static int ai_move(void) {
+    gamma_t *g = gamma_new(3, 3, 2, 1);
+    assert(g != NULL);
+
+    assert(!gamma_ai_move(NULL, 1, 10, 1));
+    assert(!gamma_ai_move(g, 0, 10, 1));
+    assert(!gamma_ai_move(g, 3, 10, 1));
+
+    // Gracz 1 może jedynie powiększyć swój obszar.
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 2, 2, 2));
+    assert(gamma_ai_move(g, 1, 50, 2));
+    assert(gamma_busy_fields(g, 1) == 2);
+
+    // Gracz bez żadnego legalnego ruchu.
+    gamma_t *h = gamma_new(1, 1, 2, 1);
+    assert(h != NULL);
+    assert(gamma_move(h, 1, 0, 0));
+    assert(gamma_golden_move(h, 2, 0, 0));
+    assert(!gamma_ai_move(h, 2, 10, 1));
+    assert(gamma_busy_fields(h, 2) == 1);
+
+    gamma_delete(g);
+    gamma_delete(h);
+    return PASS;
+}
+
 /** URUCHAMIANIE TESTÓW **/
 
 typedef struct {
@@ -786,6 +1693,20 @@ static const test_list_t test_list[] = {
         TEST(memory_alloc),
         TEST(big_board),
         TEST(middle_board),
+        TEST(legal_moves),
+        TEST(frontier),
+        TEST(fork_game),
+        TEST(hash),
+        TEST(stats),
+        TEST(trace_sessions),
+        TEST(ai_move),
+        TEST(area_registry),
+        TEST(block_connectivity),
+        TEST(concurrent_readers),
+        TEST(snapshots),
+        TEST(parallel_board),
+        TEST(check_moves),
+        TEST(check_rectangle),
 };
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,99 @@
+/** @file
+ * Implementation of the latency histogram interface
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdlib.h>
+#include "histogram.h"
+
+/** @brief Binary logarithm of the number of sub-buckets of a power of two
+ */
+#define SUB_BUCKET_BITS 4
+
+/** @brief Number of sub-buckets of a power of two
+ */
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+
+/** @brief Number of buckets needed to cover all the 64-bit values
+ *
+ * Values below @ref SUB_BUCKETS have a bucket each, then every
+ * power of two up to 2^63 gets @ref SUB_BUCKETS buckets.
+ */
+#define NUMBER_OF_BUCKETS ((64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+typedef struct HistogramData {
+    uint64_t counts[NUMBER_OF_BUCKETS]; /**< Number of values in each bucket */
+    uint64_t count;                     /**< Number of all the values */
+    uint64_t max;                       /**< Largest value */
+} *Histogram;
+
+/** @brief Returns the index of the bucket of @p value.
+ */
+static uint32_t bucket_index(uint64_t value) {
+    if (value < SUB_BUCKETS)
+        return value;
+
+    // Drop all the bits below the SUB_BUCKET_BITS + 1 most significant ones
+    uint32_t shift = 0;
+    while ((value >> shift) >= 2 * SUB_BUCKETS)
+        shift++;
+
+    return (shift + 1) * SUB_BUCKETS + (uint32_t) (value >> shift) - SUB_BUCKETS;
+}
+
+/** @brief Returns the largest value falling into the bucket @p index.
+ */
+static uint64_t bucket_highest(uint32_t index) {
+    if (index < SUB_BUCKETS)
+        return index;
+
+    uint32_t shift = index / SUB_BUCKETS - 1;
+    uint64_t lowest = (uint64_t) (index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return lowest + (((uint64_t) 1 << shift) - 1);
+}
+
+Histogram histogram_new() {
+    return calloc(1, sizeof(struct HistogramData));
+}
+
+void histogram_record(Histogram histogram, uint64_t value) {
+    histogram->counts[bucket_index(value)]++;
+    histogram->count++;
+    if (value > histogram->max)
+        histogram->max = value;
+}
+
+uint64_t histogram_count(Histogram histogram) {
+    return histogram->count;
+}
+
+uint64_t histogram_max(Histogram histogram) {
+    return histogram->max;
+}
+
+uint64_t histogram_percentile(Histogram histogram, double percentile) {
+    if (histogram->count == 0)
+        return 0;
+
+    // Number of values which have to lie at or below the result
+    uint64_t rank = (uint64_t) (percentile / 100 * (double) histogram->count);
+    if ((double) rank < percentile / 100 * (double) histogram->count)
+        rank++;
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < NUMBER_OF_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            uint64_t result = bucket_highest(i);
+            return result < histogram->max ? result : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void histogram_delete(Histogram histogram) {
+    free(histogram);
+}
@@ -0,0 +1,65 @@
+/** @file
+ * Interface for recording latency histograms
+ *
+ * The values are counted in logarithmic buckets, each power of two
+ * split into 16 linear sub-buckets, so every recorded value is known
+ * up to about 6% of it, no matter how large it is.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/** @brief Stores data of the whole histogram.
+ */
+typedef struct HistogramData *Histogram;
+
+/** @brief Allocates an empty histogram.
+ *
+ * @return Empty histogram,
+ *         i.e. pointer to the newly allocated HistogramData
+ *         or NULL if the allocation has failed
+ */
+Histogram histogram_new();
+
+/** @brief Records a single value.
+ *
+ * @param histogram     – pointer to the structure storing the histogram
+ * @param value         – value to record, e.g. a latency in nanoseconds
+ */
+void histogram_record(Histogram histogram, uint64_t value);
+
+/** @brief Returns the number of the recorded values.
+ *
+ * @param histogram     – pointer to the structure storing the histogram
+ */
+uint64_t histogram_count(Histogram histogram);
+
+/** @brief Returns the largest recorded value, zero if there are none.
+ *
+ * @param histogram     – pointer to the structure storing the histogram
+ */
+uint64_t histogram_max(Histogram histogram);
+
+/** @brief Returns a percentile of the recorded values.
+ *
+ * @param histogram     – pointer to the structure storing the histogram
+ * @param percentile    – number from [0, 100]
+ * @return The largest value equivalent to the one
+ *         below which @p percentile percent of the values lie
+ *         (never more than @ref histogram_max),
+ *         zero if there are no values.
+ */
+uint64_t histogram_percentile(Histogram histogram, double percentile);
+
+/** @brief Frees @p histogram from the memory.
+ *
+ * Does nothing if @p histogram == NULL.
+ * @param histogram     – pointer to the structure storing the histogram
+ */
+void histogram_delete(Histogram histogram);
+
+#endif //HISTOGRAM_H
@@ -17,6 +17,8 @@
 #include "print.h"
 #include "gamma.h"
 #include "moves.h"
+#include "ai.h"
+#include "trace.h"
 #include "types.c"
 
 /** @brief Returns the terminal dimensions
@@ -32,6 +34,10 @@ struct winsize terminalSize() {
     return result;
 }
 
+/** @brief How long the computer thinks about a move, in milliseconds
+ */
+#define COMPUTER_BUDGET_MS 1000
+
 /** @brief Structure storing the position on the board
  * i.e. point {0,0} is the bottom left of the screen
  */
@@ -143,9 +149,11 @@ enum Keys {
 };
 
 
-void interactive(gamma_t *g) {
+void interactive(gamma_t *g, uint32_t computers) {
 
     enableRawMode();
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = processors > 0 ? (uint32_t) processors : 1;
     bool gameOver = false;
     PositionOnBoard cursorOnBoard = {0, g->height - 1};
     uint32_t currentPlayer = 1;
@@ -154,6 +162,7 @@ void interactive(gamma_t *g) {
         bool nextMove = false;
 
         // BOARD DRAWING
+        uint64_t renderStart = trace_begin();
         char *board = gamma_board(g);
 
         size_t boardColumns = strchr(board, '\n') - board;
@@ -184,6 +193,15 @@ void interactive(gamma_t *g) {
                gamma_free_fields(g, currentPlayer),
                golden);
 
+        fflush(stdout);
+        trace_end("render", renderStart);
+
+        if (currentPlayer > g->number_of_players - computers) {
+            // The computer either moves or gives up its turn
+            gamma_ai_move(g, currentPlayer, COMPUTER_BUDGET_MS, threads);
+            nextMove = true;
+        }
+
         // Buffer storing the most recent 4 bytes
         uint32_t buffer = 0;
 
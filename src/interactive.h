@@ -14,8 +14,11 @@
  * Run the interactive mode until Ctrl-D is pressed
  * or no player has a valid move (i.e. @p gamma_free_fields == 0)
  * or an error has occured
+ * The last @p computers players are controlled by the computer
+ * (see @ref gamma_ai_move).
  * @param g         - pointer to the structure storing the game state.
+ * @param computers - number of players controlled by the computer
  */
-void interactive(gamma_t *g);
+void interactive(gamma_t *g, uint32_t computers);
 
 #endif //INTERACTIVE_H
@@ -14,60 +14,38 @@
 #include <stdlib.h>
 #include "gamma.h"
 #include "memory.h"
+#include "frontier.h"
+#include "pages.h"
+#include "board.h"
+#include "areas.h"
+#include "bitboard.h"
+#include "blocks.h"
 #include "types.c"
 
-/** @brief Allocates a 2D array.
+/** @brief Takes a reference to the resources of a copied owner.
  *
- * Allocates a 2D array of variables, each having size @p size.
- * The array must be freed by @ref free_2d.
- *
- * For example, to access the top-right corner of the board use
- * @p result[width-1][height-1]
- *
- * @param width   –  width of the array (scope of the first coordinate)
- * @param height      –  width of the array (scope of the second coordinate)
- * @param size        –  size of a single cell in the array
- *
- * @return Pointer to the 2D array or NULL if the allocation has failed.
+ * Called by @ref pages_write for each owner of a duplicated page.
+ * @param owner         – pointer to the copied OwnerData
  */
-static void **calloc_2d(uint32_t width, uint32_t height, size_t size) {
-
-    void **result = malloc(sizeof(void *[width]));
-    if (result == NULL) {
-        return NULL;
-    } else {
-        for (uint32_t i = 0; i < width; i++) {
-            result[i] = calloc(height, size);
-            if (result[i] == NULL)
-                return NULL;
-        }
-        return result;
-    }
+static void owner_copied(void *owner) {
+    frontier_share(((Owner) owner)->frontier);
 }
 
-/** @brief Frees a 2D array.
- *
- * Frees a 2D array created by @ref calloc_2d.
- * Does nothing if @p toFree is NULL.
+/** @brief Releases the resources of an owner.
  *
- * @param toFree      –  pointer to the 2D array,
- *                       a return value of @ref calloc_2d
- * @param width       –  width of the array (scope of the first coordinate),
- *                       value given to @ref calloc_2d when creating the array
+ * Called by @ref pages_delete for each owner of a freed page.
+ * @param owner         – pointer to the freed OwnerData
  */
-static void free_2d(void **toFree, uint32_t width) {
-    if (toFree != NULL) {
-        for (uint32_t i = 0; i < width; i++) {
-            free(toFree[i]);
-        }
-        free(toFree);
-    }
+static void owner_freed(void *owner) {
+    frontier_delete(((Owner) owner)->frontier);
 }
 
 gamma_t *gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas) {
 
-    if (width == 0 || height == 0 || players == 0 || areas == 0)
+    // UINT32_MAX is reserved for OUTSIDE_BOARD
+    if (width == 0 || height == 0 || players == 0 || areas == 0 ||
+        players == UINT32_MAX)
         return NULL;
 
     gamma_t *result = malloc(sizeof(gamma_t));
@@ -77,28 +55,80 @@ gamma_t *gamma_new(uint32_t width, uint32_t height,
     result->width = width;
     result->height = height;
     result->max_areas = areas;
+    result->hash = 0;
+    result->threads = 1;
+    result->labels = NULL;
+    result->areas = NULL;
+    result->rows = NULL;
+    result->blocks = NULL;
+#ifdef GAMMA_STATS
+    stats_store(&result->stats, &(GammaStats) {0});
+#endif
 
-    result->owners = calloc((int64_t) players + 1, sizeof(OwnerData));
+    result->owners = pages_new((uint64_t) players + 1, sizeof(OwnerData),
+                               owner_copied, owner_freed);
     result->number_of_players = players;
 
-    result->board = (FieldData **) calloc_2d(width, height, sizeof(FieldData));
+    bool board_created = board_new(result) && areas_new(result) &&
+                         bitboard_new(result) && blocks_new(result);
+
+    Owner fake_player = NULL;
+    if (result->owners != NULL)
+        fake_player = edit_owner(result, 0);
 
-    if (result->owners == NULL || result->board == NULL) {
+    if (fake_player == NULL || !board_created) {
+        gamma_delete(result);
         return NULL;
     } else {
         /// result->owners[0].busy_fields stores fields
         /// which do not have a pawn on them
         /// (see @ref gamma_t)
         /// Initially no field has a pawn on them
-        result->owners[0].busy_fields = width * height;
+        fake_player->busy_fields = (uint64_t) width * height;
+        return result;
+    }
+}
+
+gamma_t *gamma_fork(gamma_t *g) {
+    if (g == NULL)
+        return NULL;
+
+    gamma_t *result = malloc(sizeof(gamma_t));
+    if (result == NULL)
+        return NULL;
+
+    *result = *g;
+#ifdef GAMMA_STATS
+    GammaStats stats;
+    stats_load(&g->stats, &stats);
+    stats_store(&result->stats, &stats);
+#endif
+    result->owners = pages_fork(g->owners);
+    result->board = pages_fork(g->board);
+    result->labels = pages_fork(g->labels);
+    result->areas = pages_fork(g->areas);
+    result->rows = g->rows == NULL ? NULL : pages_fork(g->rows);
+    result->blocks = g->blocks == NULL ? NULL : pages_fork(g->blocks);
+
+    if (result->owners == NULL || result->board == NULL ||
+        result->labels == NULL || result->areas == NULL ||
+        (g->rows != NULL && result->rows == NULL) ||
+        (g->blocks != NULL && result->blocks == NULL)) {
+        gamma_delete(result);
+        return NULL;
+    } else {
         return result;
     }
 }
 
 void gamma_delete(gamma_t *g) {
     if (g != NULL) {
-        free(g->owners);
-        free_2d((void **) g->board, g->width);
+        pages_delete(g->owners);
+        pages_delete(g->board);
+        pages_delete(g->labels);
+        pages_delete(g->areas);
+        pages_delete(g->rows);
+        pages_delete(g->blocks);
         free(g);
     }
 }
@@ -21,7 +21,8 @@
  * Initializes the structure so that it represents the beginning state.
  * @param[in] width   – width of the board, positive number
  * @param[in] height  – height of the board, positive number,
- * @param[in] players – number of players, positive number,
+ * @param[in] players – number of players, positive number
+ *                      smaller than @p UINT32_MAX,
  * @param[in] areas   – maximal number of areas a player can have.
  *
  * @return Pointer to the structure or NULL if memory allocation unsucessful
@@ -30,6 +31,21 @@
 gamma_t *gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas);
 
+/** @brief Creates a copy of the game state.
+ *
+ * The copy shares the board and the data of the players
+ * with the original game. Each of the games duplicates the shared parts
+ * page by page only when it's about to modify them, so forking costs
+ * a pointer per page of the board and making a move in a fork costs
+ * roughly the same as in the original game, the frontiers of the players
+ * included.
+ * Both games can be used and deleted independently of each other.
+ * @param[in] g       – pointer to the structure storing the game state
+ * @return Pointer to the copy or NULL if @p g == NULL
+ *         or the allocation has failed.
+ */
+gamma_t *gamma_fork(gamma_t *g);
+
 /** @brief Deletes the structure storing the game state.
  *
  * Frees the structure storing the game state from memory.
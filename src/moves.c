@@ -14,6 +14,14 @@
 
 #include <stdlib.h>
 #include "board.h"
+#include "areas.h"
+#include "bitboard.h"
+#include "moves.h"
+#include "frontier.h"
+#include "pool.h"
+#include "zobrist.h"
+#include "stats.h"
+#include "trace.h"
 #include "types.c"
 
 /** @brief Changes the owner of the field.
@@ -22,59 +30,65 @@
  * (in which case it means a player of the same index)
  * or zero
  * (which will simply remove the existing owner's pawn).
- * For information on what "owner" means, go to @ref FieldData.
+ * For information on what "owner" means, go to @ref gamma_t.
  * @param g             – pointer to the structure storing the game state
  * @param new_owner     – zero or the index of the player,
  *                        positive number not greater
  *                        than the value @p players given to @ref gamma_new
- * @param position      – position of the field whose owner is to be changed
+ * @param slot          – slot of the field whose owner is to be changed
+ *                        (see @ref field_slot)
+ * @return False if the allocation has failed
+ *         (in which case nothing is changed), true otherwise.
  */
-static void change_owner(gamma_t *g, uint32_t new_owner, Position position) {
+static bool change_owner(gamma_t *g, uint32_t new_owner, uint64_t slot) {
 
-    Field field = get_field(g, position);
+    uint32_t old_owner = slot_owner(g, slot);
+    STATS_ADD(g, owner_changes, 1);
 
-    uint32_t old_owner = field->owner;
-
-    int64_t new_owner_areas_before = neighbouring_areas(g, new_owner, position, true);
-    int64_t old_owner_areas_before = neighbouring_areas(g, old_owner, position, true);
-
-    field->owner = new_owner;
-    g->owners[new_owner].busy_fields += 1;
-    g->owners[old_owner].busy_fields -= 1;
-
-    int64_t new_owner_areas_after = neighbouring_areas(g, new_owner, position, true);
-    int64_t old_owner_areas_after = neighbouring_areas(g, old_owner, position, true);
-
-    g->owners[new_owner].busy_areas += new_owner_areas_after - new_owner_areas_before;
-    g->owners[old_owner].busy_areas += old_owner_areas_after - old_owner_areas_before;
+    if (!areas_set_owner(g, slot, new_owner))
+        return false;
+    g->hash ^= zobrist_field(slot_cell(g, slot), old_owner) ^
+               zobrist_field(slot_cell(g, slot), new_owner);
+    edit_owner(g, new_owner)->busy_fields += 1;
+    edit_owner(g, old_owner)->busy_fields -= 1;
 
+    return true;
 }
 
 /** @brief Checks if changing the owner would result in an illegal situation.
  * Checks if operation @ref change_owner would make either
  * old owner or new owner exceed the area limit.
  *
+ * The numbers of areas after the change are computed without making it:
+ * the new owner's areas joined by the field merge into one (see
+ * @ref areas_joined) and the old owner's area may split
+ * (see @ref areas_without).
+ *
  * Note that the fake player (represented by @p new_owner == 0)
  * cannot exceed the area limit.
- * For information on what "owner" means, go to @ref FieldData.
+ * For information on what "owner" means, go to @ref gamma_t.
  * @param g             – pointer to the structure storing the game state
  * @param new_owner     – zero or the index of the player,
  *                        positive number not greater
  *                        than the value @p players given to @ref gamma_new
- * @param position      – position of the field whose owner is to be changed
+ * @param position      – position of the field whose owner is to be changed,
+ *                        possibly outside the board
  */
 static bool change_owner_valid(gamma_t *g, uint32_t new_owner, Position position) {
-    Field field = get_field(g, position);
+    uint32_t old_owner = get_field_owner(g, position);
 
-    if (field != NULL) {
+    if (old_owner != OUTSIDE_BOARD) {
 
-        uint32_t old_owner = field->owner;
+        uint64_t slot = field_slot(g, position);
+        STATS_ADD(g, trial_validations, 1);
 
-        change_owner(g, new_owner, position);
-        bool result = (g->owners[new_owner].busy_areas <= g->max_areas) &&
-                      (g->owners[old_owner].busy_areas <= g->max_areas);
-
-        change_owner(g, old_owner, position);
+        bool result = true;
+        if (new_owner != 0)
+            result = get_owner(g, new_owner)->busy_areas + 1 -
+                     areas_joined(g, slot, new_owner) <= g->max_areas;
+        if (result && old_owner != 0)
+            result = get_owner(g, old_owner)->busy_areas - 1 +
+                     areas_without(g, slot) <= g->max_areas;
 
         return result;
     } else {
@@ -93,14 +107,14 @@ static bool change_owner_valid(gamma_t *g, uint32_t new_owner, Position position
  * @return @p true, if the golden move is valid or @p false otherwise
  */
 static bool golden_move_valid(gamma_t *g, uint32_t player, Position position) {
-    Field field = get_field(g, position);
+    uint32_t owner = get_field_owner(g, position);
 
     return player <= g->number_of_players &&
            player > 0 &&
-           !g->owners[player].golden_move_used &&
-           field != NULL &&
-           field->owner != 0 &&
-           field->owner != player &&
+           !get_owner(g, player)->golden_move_used &&
+           owner != OUTSIDE_BOARD &&
+           owner != 0 &&
+           owner != player &&
            change_owner_valid(g, player, position);
 }
 
@@ -113,12 +127,9 @@ static bool golden_move_valid(gamma_t *g, uint32_t player, Position position) {
  * @return @p true, if the move is valid or @p false otherwise
  */
 static bool move_valid(gamma_t *g, uint32_t player, Position position) {
-    Field field = get_field(g, position);
-
     return player <= g->number_of_players &&
            player > 0 &&
-           field != NULL &&
-           field->owner == 0 &&
+           get_field_owner(g, position) == 0 &&
            change_owner_valid(g, player, position);
 }
 
@@ -127,45 +138,339 @@ bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     if(g == NULL)
         return false;
 
+    uint64_t start = trace_begin();
     Position position = {x, y};
-    if (golden_move_valid(g, player, position)) {
-        change_owner(g, player, position);
-        g->owners[player].golden_move_used = true;
-        return true;
-    } else {
-        return false;
+    bool result = golden_move_valid(g, player, position) &&
+                  change_owner(g, player, field_slot(g, position));
+    if (result) {
+        edit_owner(g, player)->golden_move_used = true;
+        g->hash ^= zobrist_golden(player);
     }
+    trace_end("gamma_golden_move", start);
+    return result;
 }
 
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y) {
     if(g == NULL)
         return false;
 
+    uint64_t start = trace_begin();
     Position position = {x, y};
-    if (move_valid(g, player, position)) {
-        change_owner(g, player, position);
-        return true;
+    bool result = move_valid(g, player, position) &&
+                  change_owner(g, player, field_slot(g, position));
+    trace_end("gamma_move", start);
+    return result;
+}
+
+
+uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
+    if (g == NULL || player == 0 || player > g->number_of_players)
+        return 0;
+
+    uint64_t start = trace_begin();
+    uint64_t result;
+    // A player below the area limit may place a pawn on any free field,
+    // otherwise only on the fields neighbouring one of his areas
+    if (get_owner(g, player)->busy_areas < g->max_areas)
+        result = get_owner(g, 0)->busy_fields;
+    else
+        result = frontier_size(get_owner(g, player)->frontier);
+    trace_end("gamma_free_fields", start);
+    return result;
+}
+
+/** @brief Phases of the enumeration of the legal moves
+ */
+enum LegalMovesPhase {
+    FRONTIER,           /**< Reading ordinary moves from the frontier */
+    FREE_FIELDS,        /**< Scanning the board for free fields */
+    GOLDEN_AREAS,       /**< Scanning the boxes of the areas
+                             for golden moves */
+    GOLDEN,             /**< Scanning the board for golden moves */
+    FINISHED            /**< All the legal moves have been read */
+};
+
+typedef struct LegalMovesData {
+    gamma_t *g;                  /**< Game whose moves are enumerated */
+    uint32_t player;             /**< Player whose moves are enumerated */
+    bool at_limit;               /**< Has the player reached
+                                      the area limit */
+    enum LegalMovesPhase phase;  /**< Which moves are being read now */
+    uint32_t area;               /**< Area whose box is being scanned */
+    uint64_t next;               /**< Next slot of the frontier,
+                                      next field of the board
+                                      or of the box to check */
+} *LegalMoves;
+
+/** @brief Returns the next area whose box may hold golden moves.
+ *
+ * At the area limit a golden move must neighbour one of the player's
+ * areas, so these are his areas. Below the limit any field of another
+ * player will do, so these are the areas of the other players.
+ * @param moves         – the cursor
+ * @param area          – id of the previous area, zero to get the first one
+ * @return Id of the area, zero if there are no more.
+ */
+static uint32_t next_golden_area(LegalMoves moves, uint32_t area) {
+    gamma_t *g = moves->g;
+    if (moves->at_limit)
+        return area == 0 ? get_owner(g, moves->player)->first_area :
+               areas_next(g, area);
+
+    GammaArea data;
+    for (area++; area < g->next_area; area++)
+        if (gamma_area(g, area, &data) && data.player != moves->player)
+            return area;
+    return 0;
+}
+
+/** @brief Finds the box of the fields to check for an area.
+ *
+ * The box is the bounding box of the area, extended
+ * by the neighbouring fields at the area limit.
+ * @param moves         – the cursor
+ * @param area          – id of an area, see @ref next_golden_area
+ * @param min           – where to store the corner with the least coordinates
+ * @param max           – where to store the corner with the largest ones
+ * @return Number of the fields of the box.
+ */
+static uint64_t golden_box(LegalMoves moves, uint32_t area,
+                           Position *min, Position *max) {
+    gamma_t *g = moves->g;
+    GammaArea data;
+    gamma_area(g, area, &data);
+
+    int64_t margin = moves->at_limit ? 1 : 0;
+    min->x = data.min_x > margin ? data.min_x - margin : 0;
+    min->y = data.min_y > margin ? data.min_y - margin : 0;
+    max->x = data.max_x + margin < g->width ? data.max_x + margin :
+             g->width - 1;
+    max->y = data.max_y + margin < g->height ? data.max_y + margin :
+             g->height - 1;
+    return (uint64_t) (max->x - min->x + 1) * (max->y - min->y + 1);
+}
+
+/** @brief Checks if a field of the box of an area is to be checked.
+ *
+ * Every field is checked in the box of a single area: below the limit
+ * in the box of its own area, at the limit in the box of the player's
+ * area with the smallest id among the ones it neighbours.
+ * @param moves         – the cursor
+ * @param position      – position of a field inside the box
+ *                        of @p moves->area
+ */
+static bool golden_candidate(LegalMoves moves, Position position) {
+    gamma_t *g = moves->g;
+    if (!moves->at_limit)
+        return gamma_area_id(g, position.x, position.y) == moves->area;
+
+    uint64_t slot = field_slot(g, position);
+    uint32_t first = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t neighbour = slot + g->neighbour_offsets[i];
+        if (slot_owner(g, neighbour) == moves->player) {
+            Position p = slot_position(g, neighbour);
+            uint32_t area = gamma_area_id(g, p.x, p.y);
+            if (first == 0 || area < first)
+                first = area;
+        }
+    }
+    return first == moves->area;
+}
+
+/** @brief Chooses how to look for the golden moves.
+ *
+ * Scans the boxes of the areas unless they cover together
+ * at least as many fields as the board.
+ * @param moves         – the cursor
+ * @return The phase reading the golden moves.
+ */
+static enum LegalMovesPhase golden_phase(LegalMoves moves) {
+    uint64_t fields = (uint64_t) moves->g->width * moves->g->height;
+    uint64_t covered = 0;
+    Position min, max;
+    for (uint32_t area = next_golden_area(moves, 0);
+         area != 0 && covered < fields;
+         area = next_golden_area(moves, area))
+        covered += golden_box(moves, area, &min, &max);
+
+    moves->area = next_golden_area(moves, 0);
+    if (covered >= fields)
+        return GOLDEN;
+    else if (moves->area != 0)
+        return GOLDEN_AREAS;
+    else
+        return FINISHED;
+}
+
+/** @brief Returns the phase following @p phase.
+ *
+ * Skips the phases which cannot produce any moves.
+ * @param moves         – the cursor
+ * @param phase         – the phase that has just been finished
+ */
+static enum LegalMovesPhase next_phase(LegalMoves moves,
+                                       enum LegalMovesPhase phase) {
+    if (phase == FRONTIER || phase == FREE_FIELDS) {
+        if (!get_owner(moves->g, moves->player)->golden_move_used)
+            return golden_phase(moves);
+        else
+            return FINISHED;
     } else {
-        return false;
+        return FINISHED;
     }
 }
 
+LegalMoves gamma_legal_moves(gamma_t *g, uint32_t player) {
+    if (g == NULL || player == 0 || player > g->number_of_players)
+        return NULL;
 
-uint64_t gamma_free_fields(gamma_t *g, uint32_t player) {
-    if(g == NULL)
-        return false;
+    LegalMoves result = malloc(sizeof(struct LegalMovesData));
+    if (result == NULL)
+        return NULL;
+
+    result->g = g;
+    result->player = player;
+    result->next = 0;
+    result->area = 0;
+
+    // See gamma_free_fields
+    result->at_limit = get_owner(g, player)->busy_areas >= g->max_areas;
+    if (result->at_limit)
+        result->phase = FRONTIER;
+    else
+        result->phase = FREE_FIELDS;
 
-    uint64_t result = 0;
-    for (uint32_t x = 0; x < g->width; x++) {
-        for (uint32_t y = 0; y < g->height; y++) {
-            Position position = {x, y};
-            if (move_valid(g, player, position))
-                result++;
+    return result;
+}
+
+uint32_t gamma_legal_moves_next(LegalMoves moves, LegalMove *buffer,
+                                uint32_t size) {
+    gamma_t *g = moves->g;
+    uint64_t fields = (uint64_t) g->width * g->height;
+    Frontier frontier = get_owner(g, moves->player)->frontier;
+
+    uint32_t result = 0;
+    while (result < size && moves->phase != FINISHED) {
+        uint64_t cell;
+        bool found = false;
+
+        switch (moves->phase) {
+            case FRONTIER:
+                if (moves->next < frontier_capacity(frontier)) {
+                    found = frontier_slot(frontier, moves->next++, &cell);
+                } else {
+                    moves->phase = next_phase(moves, moves->phase);
+                    moves->next = 0;
+                }
+                break;
+            case FREE_FIELDS:
+                moves->next = bitboard_next(g, 0, moves->next);
+                if (moves->next < fields) {
+                    cell = moves->next++;
+                    found = get_field_owner(g, cell_position(g, cell)) == 0;
+                } else {
+                    moves->phase = next_phase(moves, moves->phase);
+                    moves->next = 0;
+                }
+                break;
+            case GOLDEN_AREAS: {
+                Position min, max;
+                uint64_t box = golden_box(moves, moves->area, &min, &max);
+                if (moves->next < box) {
+                    uint64_t box_width = max.x - min.x + 1;
+                    Position position = {min.x + moves->next % box_width,
+                                         min.y + moves->next / box_width};
+                    moves->next++;
+                    cell = cell_index(g, position);
+                    found = golden_candidate(moves, position) &&
+                            golden_move_valid(g, moves->player, position);
+                } else {
+                    moves->area = next_golden_area(moves, moves->area);
+                    moves->next = 0;
+                    if (moves->area == 0)
+                        moves->phase = next_phase(moves, moves->phase);
+                }
+                break;
+            }
+            case GOLDEN:
+                if (moves->next < fields) {
+                    cell = moves->next++;
+                    Position position = cell_position(g, cell);
+                    // At the limit a field away from the player's areas
+                    // would give him a new area, don't bother checking it
+                    found = (!moves->at_limit ||
+                             neighbours_owner(g, field_slot(g, position),
+                                              moves->player)) &&
+                            golden_move_valid(g, moves->player, position);
+                } else {
+                    moves->phase = next_phase(moves, moves->phase);
+                }
+                break;
+            case FINISHED:
+                break;
+        }
+
+        if (found) {
+            Position position = cell_position(g, cell);
+            buffer[result].x = position.x;
+            buffer[result].y = position.y;
+            buffer[result].golden = moves->phase == GOLDEN_AREAS ||
+                                    moves->phase == GOLDEN;
+            result++;
         }
     }
 
     return result;
 }
 
+void gamma_legal_moves_delete(LegalMoves moves) {
+    free(moves);
+}
 
+/** @brief Number of moves checked by a single task
+ */
+#define CHECK_CHUNK 1024
 
+/** @brief Structure storing the state of checking many moves
+ */
+typedef struct Check {
+    gamma_t *g;                  /**< The game */
+    uint32_t player;             /**< Player making the moves */
+    const LegalMove *moves;      /**< The moves */
+    uint64_t count;              /**< Number of the moves */
+    bool *results;               /**< Whether each move is legal */
+} Check;
+
+/** @brief Checks a chunk of moves, see @ref PoolTask.
+ */
+static void check_chunk(void *arg, uint64_t index) {
+    Check *check = arg;
+    uint64_t end = (index + 1) * CHECK_CHUNK;
+    if (end > check->count)
+        end = check->count;
+
+    for (uint64_t i = index * CHECK_CHUNK; i < end; i++) {
+        Position position = {check->moves[i].x, check->moves[i].y};
+        if (check->moves[i].golden)
+            check->results[i] = golden_move_valid(check->g, check->player,
+                                                  position);
+        else
+            check->results[i] = move_valid(check->g, check->player,
+                                           position);
+    }
+}
+
+bool gamma_check_moves(gamma_t *g, uint32_t player, const LegalMove *moves,
+                       uint64_t count, bool *results, uint32_t threads) {
+    if (g == NULL || player == 0 || player > g->number_of_players ||
+        (count > 0 && (moves == NULL || results == NULL)) || threads == 0)
+        return false;
+
+    uint64_t start = trace_begin();
+    Check check = {g, player, moves, count, results};
+    pool_run(threads, (count + CHECK_CHUNK - 1) / CHECK_CHUNK, check_chunk,
+             &check);
+    trace_end("gamma_check_moves", start);
+    return true;
+}
@@ -58,4 +58,77 @@ bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
  */
 uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
 
+/** @brief Structure storing a single move
+ */
+typedef struct LegalMove {
+    uint32_t x;         /**< Index of the column */
+    uint32_t y;         /**< Index of the row */
+    bool golden;        /**< Is it a golden move */
+} LegalMove;
+
+/** @brief Stores the state of an enumeration of the legal moves.
+ */
+typedef struct LegalMovesData *LegalMoves;
+
+/** @brief Starts enumerating the legal moves of a player.
+ *
+ * Creates a cursor, from which the legal moves of @p player
+ * are read with @ref gamma_legal_moves_next: first all the ordinary moves
+ * (see @ref gamma_move), then all the golden moves
+ * (see @ref gamma_golden_move).
+ * The cursor must be freed with @ref gamma_legal_moves_delete.
+ * Making any move invalidates the cursor, it may only be freed then.
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – index of the player, positive number not greater
+ *                        than the value @p players given to @ref gamma_new
+ * @return Pointer to the cursor or NULL if one of the parameters is invalid
+ *         or the allocation has failed.
+ */
+LegalMoves gamma_legal_moves(gamma_t *g, uint32_t player);
+
+/** @brief Reads the next batch of legal moves.
+ *
+ * Each legal move is returned by exactly one call.
+ * Fields where the player may place his pawn with an ordinary move
+ * are taken from his frontier once he has reached the area limit,
+ * so a batch does not cost more than scanning the board.
+ * Golden moves are looked for in the bounding boxes of the areas
+ * they may capture or neighbour (see @ref gamma_area), the board
+ * is scanned only if the boxes cover it anyway.
+ * @param moves         – cursor created by @ref gamma_legal_moves
+ * @param buffer        – array where the moves are saved
+ * @param size          – length of @p buffer
+ * @return Number of moves saved in @p buffer,
+ *         zero means all the legal moves have already been read.
+ */
+uint32_t gamma_legal_moves_next(LegalMoves moves, LegalMove *buffer,
+                                uint32_t size);
+
+/** @brief Frees the cursor from the memory.
+ *
+ * Does nothing if @p moves == NULL.
+ * @param moves         – cursor created by @ref gamma_legal_moves
+ */
+void gamma_legal_moves_delete(LegalMoves moves);
+
+/** @brief Checks many moves of a player at once.
+ *
+ * Sets @p results[i] to whether @p moves[i] is legal: an ordinary move
+ * (see @ref gamma_move) or, if @p moves[i].golden is set,
+ * a golden move (see @ref gamma_golden_move). No move is made.
+ * The moves are split between @p threads threads (see @ref pool.h),
+ * which only read the game, so it must not be changed meanwhile.
+ * @param g             – pointer to the structure storing the game state
+ * @param player        – index of the player, positive number not greater
+ *                        than the value @p players given to @ref gamma_new
+ * @param moves         – the moves, a move outside the board is illegal
+ * @param count         – length of @p moves and @p results
+ * @param results       – where to store whether each move is legal
+ * @param threads       – number of threads, positive number
+ * @return @p true, if the results have been stored, @p false if one
+ *         of the parameters is invalid.
+ */
+bool gamma_check_moves(gamma_t *g, uint32_t player, const LegalMove *moves,
+                       uint64_t count, bool *results, uint32_t threads);
+
 #endif //MOVE_H
@@ -0,0 +1,190 @@
+/** @file
+ * Implementation of the interface for managing arrays
+ * shared copy-on-write between games
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "pages.h"
+
+/** @brief Binary logarithm of the maximal number of elements on a page
+ */
+#define MAX_PAGE_SHIFT 12
+
+/** @brief Stores data of a single page
+ */
+typedef struct PageData {
+    atomic_uint_fast64_t refcount; /**< Number of the page table entries
+                                        (in all arrays) pointing to this
+                                        page, forks of a game may be used
+                                        by different threads */
+    unsigned char data[];  /**< Elements stored on the page */
+} *Page;
+
+typedef struct PagesData {
+    Page *pages;              /**< Page table, the element with index i
+                                   lies on the page pages[i >> page_shift] */
+    uint64_t number_of_pages; /**< Length of @p pages */
+    uint32_t page_shift;      /**< Binary logarithm of the number
+                                   of elements on a page */
+    size_t element_size;      /**< Size of a single element */
+    PagesElementHook on_copy; /**< See @ref pages_new */
+    PagesElementHook on_free; /**< See @ref pages_new */
+} *Pages;
+
+/** @brief Returns the size of a page in bytes.
+ */
+static size_t page_bytes(Pages pages) {
+    return sizeof(struct PageData) +
+           (pages->element_size << pages->page_shift);
+}
+
+/** @brief Calls @p hook for each element of @p page.
+ *
+ * Does nothing if @p hook == NULL.
+ */
+static void for_each_element(Pages pages, Page page, PagesElementHook hook) {
+    if (hook != NULL) {
+        uint64_t elements = (uint64_t) 1 << pages->page_shift;
+        for (uint64_t i = 0; i < elements; i++)
+            hook(page->data + i * pages->element_size);
+    }
+}
+
+/** @brief Drops one reference to @p page, freeing it if it was the last one.
+ */
+static void page_release(Pages pages, Page page) {
+    if (atomic_fetch_sub_explicit(&page->refcount, 1,
+                                  memory_order_acq_rel) == 1) {
+        for_each_element(pages, page, pages->on_free);
+        free(page);
+    }
+}
+
+Pages pages_new(uint64_t count, size_t element_size,
+                PagesElementHook on_copy, PagesElementHook on_free) {
+    if (count == 0 || element_size == 0)
+        return NULL;
+
+    Pages result = malloc(sizeof(struct PagesData));
+    if (result == NULL)
+        return NULL;
+
+    // Small arrays fit on a single, smaller page
+    result->page_shift = 0;
+    while (result->page_shift < MAX_PAGE_SHIFT &&
+           ((uint64_t) 1 << result->page_shift) < count)
+        result->page_shift++;
+
+    result->element_size = element_size;
+    result->on_copy = on_copy;
+    result->on_free = on_free;
+    result->number_of_pages = ((count - 1) >> result->page_shift) + 1;
+
+    Page zero_page = calloc(1, page_bytes(result));
+    if (result->number_of_pages > SIZE_MAX / sizeof(Page))
+        result->pages = NULL;
+    else
+        result->pages = malloc(result->number_of_pages * sizeof(Page));
+
+    if (zero_page == NULL || result->pages == NULL) {
+        free(zero_page);
+        free(result->pages);
+        free(result);
+        return NULL;
+    }
+
+    atomic_init(&zero_page->refcount, result->number_of_pages);
+    for (uint64_t i = 0; i < result->number_of_pages; i++)
+        result->pages[i] = zero_page;
+
+    return result;
+}
+
+Pages pages_fork(Pages pages) {
+    Pages result = malloc(sizeof(struct PagesData));
+    if (result == NULL)
+        return NULL;
+
+    *result = *pages;
+    result->pages = malloc(pages->number_of_pages * sizeof(Page));
+    if (result->pages == NULL) {
+        free(result);
+        return NULL;
+    }
+
+    for (uint64_t i = 0; i < pages->number_of_pages; i++) {
+        result->pages[i] = pages->pages[i];
+        atomic_fetch_add_explicit(&result->pages[i]->refcount, 1,
+                                  memory_order_relaxed);
+    }
+
+    return result;
+}
+
+uint64_t pages_page_size(Pages pages) {
+    return (uint64_t) 1 << pages->page_shift;
+}
+
+void pages_share(Pages pages, uint64_t to, uint64_t from) {
+    Page shared = pages->pages[from >> pages->page_shift];
+    Page *replaced = &pages->pages[to >> pages->page_shift];
+    if (*replaced != shared) {
+        atomic_fetch_add_explicit(&shared->refcount, 1, memory_order_relaxed);
+        page_release(pages, *replaced);
+        *replaced = shared;
+    }
+}
+
+const void *pages_read(Pages pages, uint64_t index) {
+    uint64_t offset = index & (((uint64_t) 1 << pages->page_shift) - 1);
+    return pages->pages[index >> pages->page_shift]->data +
+           offset * pages->element_size;
+}
+
+const void *pages_read_run(Pages pages, uint64_t index, uint64_t *count) {
+    uint64_t offset = index & (((uint64_t) 1 << pages->page_shift) - 1);
+    *count = ((uint64_t) 1 << pages->page_shift) - offset;
+    return pages_read(pages, index);
+}
+
+void *pages_write(Pages pages, uint64_t index) {
+    Page *page = &pages->pages[index >> pages->page_shift];
+
+    if (atomic_load_explicit(&(*page)->refcount, memory_order_acquire) > 1) {
+        Page copy = malloc(page_bytes(pages));
+        if (copy == NULL)
+            return NULL;
+
+        // The reference count may be changed by another thread meanwhile,
+        // copy only the elements
+        memcpy(copy->data, (*page)->data, page_bytes(pages) -
+                                          sizeof(struct PageData));
+        atomic_init(&copy->refcount, 1);
+        for_each_element(pages, copy, pages->on_copy);
+
+        page_release(pages, *page);
+        *page = copy;
+    }
+
+    uint64_t offset = index & (((uint64_t) 1 << pages->page_shift) - 1);
+    return (*page)->data + offset * pages->element_size;
+}
+
+void *pages_write_run(Pages pages, uint64_t index, uint64_t *count) {
+    uint64_t offset = index & (((uint64_t) 1 << pages->page_shift) - 1);
+    *count = ((uint64_t) 1 << pages->page_shift) - offset;
+    return pages_write(pages, index);
+}
+
+void pages_delete(Pages pages) {
+    if (pages != NULL) {
+        for (uint64_t i = 0; i < pages->number_of_pages; i++)
+            page_release(pages, pages->pages[i]);
+        free(pages->pages);
+        free(pages);
+    }
+}
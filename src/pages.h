@@ -0,0 +1,122 @@
+/** @file
+ * Interface for managing arrays shared copy-on-write between games
+ *
+ * An array is split into pages of equal size. A forked array shares
+ * all the pages with the original one and a page is duplicated
+ * only when one of the arrays is about to modify it.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef PAGES_H
+#define PAGES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Stores data of the whole array.
+ */
+typedef struct PagesData *Pages;
+
+/** @brief Function called for a single element of a page.
+ *
+ * Used to manage the resources an element points to,
+ * see @ref pages_new.
+ */
+typedef void (*PagesElementHook)(void *element);
+
+/** @brief Allocates an array filled with zeros.
+ *
+ * Initially all the pages of the array are the same zero-filled page,
+ * so the memory is only allocated for the pages that get modified.
+ * @param count         – number of elements of the array
+ * @param element_size  – size of a single element
+ * @param on_copy       – called for each element of a page
+ *                        right after the page has been duplicated,
+ *                        NULL if not needed
+ * @param on_free       – called for each element of a page
+ *                        right before the page is freed,
+ *                        NULL if not needed
+ * @return Pointer to the array or NULL if the allocation has failed.
+ */
+Pages pages_new(uint64_t count, size_t element_size,
+                PagesElementHook on_copy, PagesElementHook on_free);
+
+/** @brief Creates a copy of the array sharing all the pages with it.
+ *
+ * Costs one pointer per page, no element is copied.
+ * @param pages         – pointer to the structure storing the array
+ * @return Pointer to the copy or NULL if the allocation has failed.
+ */
+Pages pages_fork(Pages pages);
+
+/** @brief Returns the number of elements on a single page.
+ *
+ * @param pages         – pointer to the structure storing the array
+ * @return A power of two.
+ */
+uint64_t pages_page_size(Pages pages);
+
+/** @brief Makes a page share the contents of another one.
+ *
+ * The page of the element @p to is replaced, costing no copy,
+ * by the page of the element @p from. Like after @ref pages_fork,
+ * the page is copied when written.
+ * @param pages         – pointer to the structure storing the array
+ * @param to            – index of an element of the replaced page
+ * @param from          – index of an element of the shared page
+ */
+void pages_share(Pages pages, uint64_t to, uint64_t from);
+
+/** @brief Returns a pointer to the element for reading.
+ *
+ * The element must not be modified through the returned pointer.
+ * @param pages         – pointer to the structure storing the array
+ * @param index         – index of the element
+ */
+const void *pages_read(Pages pages, uint64_t index);
+
+/** @brief Returns a pointer to consecutive elements for reading.
+ *
+ * The elements from @p index to the end of its page are stored
+ * one after another, so they may be read through the returned pointer
+ * like an array. They must not be modified through it.
+ * @param pages         – pointer to the structure storing the array
+ * @param index         – index of the first element
+ * @param count         – where to store the number of the elements
+ *                        (possibly past the end of the array)
+ */
+const void *pages_read_run(Pages pages, uint64_t index, uint64_t *count);
+
+/** @brief Returns a pointer to the element for writing.
+ *
+ * Duplicates the page of the element if it's shared with another array.
+ * @param pages         – pointer to the structure storing the array
+ * @param index         – index of the element
+ * @return Pointer to the element or NULL if the allocation has failed.
+ */
+void *pages_write(Pages pages, uint64_t index);
+
+/** @brief Returns a pointer to consecutive elements for writing.
+ *
+ * Like @ref pages_write, but the elements from @p index to the end
+ * of its page may be modified through the returned pointer
+ * like an array.
+ * @param pages         – pointer to the structure storing the array
+ * @param index         – index of the first element
+ * @param count         – where to store the number of the elements
+ *                        (possibly past the end of the array)
+ * @return Pointer to the element or NULL if the allocation has failed.
+ */
+void *pages_write_run(Pages pages, uint64_t index, uint64_t *count);
+
+/** @brief Frees @p pages from the memory.
+ *
+ * The pages still shared with other arrays are not freed.
+ * Does nothing if @p pages == NULL.
+ * @param pages         – pointer to the structure storing the array
+ */
+void pages_delete(Pages pages);
+
+#endif //PAGES_H
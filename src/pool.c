@@ -0,0 +1,187 @@
+/** @file
+ * Implementation of the pool of threads splitting scans of the board
+ *
+ * The jobs waiting for threads are kept in a list guarded by a mutex.
+ * The tasks of a job are taken by incrementing an atomic counter,
+ * so the threads only take the mutex to join and to leave a job.
+ * The job lives on the stack of its calling thread, which unlinks it
+ * once no thread of the pool works on it anymore. The pool has at most
+ * one thread per processor online and is joined at exit,
+ * see @ref pool_shutdown.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "pool.h"
+
+/** @brief Stores a single job
+ */
+typedef struct JobData {
+    PoolTask task;                 /**< Function running a task */
+    void *arg;                     /**< Argument of the tasks */
+    uint64_t tasks;                /**< Number of the tasks */
+    atomic_uint_fast64_t next;     /**< Index of the next task to take */
+    uint32_t helpers;              /**< Threads of the pool which may still
+                                        join the job */
+    uint32_t working;              /**< Threads of the pool running its tasks,
+                                        guarded by @ref lock */
+    struct JobData *next_job;      /**< Next job of the list */
+} *Job;
+
+/** @brief Guards the list of the jobs and the number of the threads */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** @brief Signalled when a job is added to the list */
+static pthread_cond_t job_added = PTHREAD_COND_INITIALIZER;
+
+/** @brief Signalled when a thread of the pool leaves a job */
+static pthread_cond_t job_left = PTHREAD_COND_INITIALIZER;
+
+/** @brief Jobs waiting for threads, from the latest one */
+static Job jobs = NULL;
+
+/** @brief Threads of the pool, NULL until the first one is started */
+static pthread_t *threads_started = NULL;
+
+/** @brief Number of the threads of the pool */
+static uint32_t number_of_threads = 0;
+
+/** @brief Maximal number of the threads of the pool,
+ * the length of @ref threads_started */
+static uint32_t max_threads = 0;
+
+/** @brief Has @ref pool_shutdown been registered to run at exit */
+static bool shutdown_registered = false;
+
+/** @brief Are the threads of the pool to finish once no job is left */
+static bool stopping = false;
+
+/** @brief Runs the tasks of a job until none is left to take.
+ */
+static void run_tasks(Job job) {
+    uint64_t index;
+    while ((index = atomic_fetch_add(&job->next, 1)) < job->tasks)
+        job->task(job->arg, index);
+}
+
+/** @brief Returns a job a thread of the pool may join, NULL if none.
+ *
+ * Must be called with @ref lock held.
+ */
+static Job joinable_job() {
+    for (Job job = jobs; job != NULL; job = job->next_job)
+        if (job->helpers > 0 && atomic_load(&job->next) < job->tasks)
+            return job;
+    return NULL;
+}
+
+/** @brief Body of a thread of the pool.
+ */
+static void *pool_thread(void *unused) {
+    (void) unused;
+    pthread_mutex_lock(&lock);
+    while (true) {
+        Job job = joinable_job();
+        if (job == NULL && stopping)
+            break;
+        if (job == NULL) {
+            pthread_cond_wait(&job_added, &lock);
+            continue;
+        }
+
+        job->helpers--;
+        job->working++;
+        pthread_mutex_unlock(&lock);
+        run_tasks(job);
+        pthread_mutex_lock(&lock);
+        if (--job->working == 0)
+            pthread_cond_broadcast(&job_left);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+/** @brief Starts threads until the pool has @p threads of them.
+ *
+ * Must be called with @ref lock held.
+ * Starts at most one thread per processor online
+ * and stops at the first thread which cannot be started.
+ */
+static void grow_pool(uint32_t threads) {
+    if (stopping)
+        return;
+
+    if (threads_started == NULL) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        max_threads = processors > 0 && processors < UINT32_MAX ?
+                      (uint32_t) processors : 1;
+        threads_started = malloc(max_threads * sizeof(pthread_t));
+        if (threads_started == NULL)
+            return;
+        if (!shutdown_registered)
+            shutdown_registered = atexit(pool_shutdown) == 0;
+    }
+    if (threads > max_threads)
+        threads = max_threads;
+
+    for (; number_of_threads < threads; number_of_threads++)
+        if (pthread_create(&threads_started[number_of_threads], NULL,
+                           pool_thread, NULL) != 0)
+            break;
+}
+
+void pool_run(uint32_t threads, uint64_t tasks, PoolTask task, void *arg) {
+    if (threads <= 1 || tasks <= 1) {
+        for (uint64_t index = 0; index < tasks; index++)
+            task(arg, index);
+        return;
+    }
+
+    // The calling thread is one of the threads
+    struct JobData job = {.task = task, .arg = arg, .tasks = tasks,
+                          .helpers = threads - 1, .working = 0};
+    atomic_init(&job.next, 0);
+
+    pthread_mutex_lock(&lock);
+    grow_pool(threads - 1);
+    job.next_job = jobs;
+    jobs = &job;
+    pthread_cond_broadcast(&job_added);
+    pthread_mutex_unlock(&lock);
+
+    run_tasks(&job);
+
+    pthread_mutex_lock(&lock);
+    while (job.working > 0)
+        pthread_cond_wait(&job_left, &lock);
+    Job *link = &jobs;
+    while (*link != &job)
+        link = &(*link)->next_job;
+    *link = job.next_job;
+    pthread_mutex_unlock(&lock);
+}
+
+void pool_shutdown() {
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_broadcast(&job_added);
+    pthread_mutex_unlock(&lock);
+
+    // The threads finish the jobs they may join before leaving
+    for (uint32_t i = 0; i < number_of_threads; i++)
+        pthread_join(threads_started[i], NULL);
+
+    pthread_mutex_lock(&lock);
+    free(threads_started);
+    threads_started = NULL;
+    number_of_threads = 0;
+    stopping = false;
+    pthread_mutex_unlock(&lock);
+}
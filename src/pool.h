@@ -0,0 +1,46 @@
+/** @file
+ * Interface of the pool of threads splitting scans of the board
+ *
+ * A job is split into tasks, which the calling thread runs together
+ * with the threads of the pool. The threads are started when first
+ * needed and wait for the next job afterwards; a single pool serves
+ * all the games and all the threads calling @ref pool_run.
+ * The pool has at most one thread per processor online.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+
+/** @brief Task of a job.
+ *
+ * @param arg           – argument of the job
+ * @param index         – index of the task, less than the number of tasks
+ */
+typedef void (*PoolTask)(void *arg, uint64_t index);
+
+/** @brief Runs a job and waits for all its tasks to finish.
+ *
+ * At most @p threads threads (including the calling one) run
+ * the tasks at once. The tasks may run in any order, so they
+ * must not depend on each other. If the threads cannot be started,
+ * the calling thread runs all the tasks itself.
+ * @param threads       – number of threads, positive number
+ * @param tasks         – number of tasks
+ * @param task          – function running a single task
+ * @param arg           – argument passed to each of the tasks
+ */
+void pool_run(uint32_t threads, uint64_t tasks, PoolTask task, void *arg);
+
+/** @brief Stops the threads of the pool and waits for them to finish.
+ *
+ * Called at exit, the threads are started again by the next
+ * @ref pool_run. Must not be called by a thread of the pool
+ * nor by two threads at once.
+ */
+void pool_shutdown();
+
+#endif //POOL_H
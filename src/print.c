@@ -15,7 +15,18 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdatomic.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include "gamma.h"
+#include "board.h"
+#include "pool.h"
+#include "stats.h"
+#include "trace.h"
 #include "types.c"
 
 /** @brief Returns the number of digits of a given number.
@@ -43,53 +54,229 @@ char *owner_to_str(uint32_t owner) {
     return result_beginning;
 }
 
+/** @brief Widest column rendered with the lookup table of the owners
+ */
+#define MAX_TABLE_DIGITS 3
+
+/** @brief Number of owners with at most @ref MAX_TABLE_DIGITS digits
+ */
+#define TABLE_SIZE 1000
+
+/** @brief Renders a row of owners, each being a single digit or zero.
+ *
+ * Writes @p width characters, '.' for a free field
+ * and the digit of the owner otherwise.
+ * Converts 32 or 16 fields at a time when AVX2 or SSE2 is available.
+ * @param owners        – owners of the fields of the row, at most 9
+ * @param width         – number of the fields
+ * @param out           – where to write
+ * @return Pointer to the character after the row.
+ */
+static char *render_digits(const uint32_t *owners, uint32_t width, char *out) {
+    uint32_t x = 0;
+
+#ifdef __AVX2__
+    const __m256i free_avx = _mm256_set1_epi8('.');
+    const __m256i zero_avx = _mm256_set1_epi8('0');
+    // Packing works within 128-bit lanes, this puts the groups
+    // of four fields back in order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; x + 32 <= width; x += 32) {
+        const __m256i *in = (const __m256i *) (owners + x);
+        __m256i low = _mm256_packs_epi32(_mm256_loadu_si256(in),
+                                         _mm256_loadu_si256(in + 1));
+        __m256i high = _mm256_packs_epi32(_mm256_loadu_si256(in + 2),
+                                          _mm256_loadu_si256(in + 3));
+        __m256i bytes = _mm256_permutevar8x32_epi32(
+                _mm256_packus_epi16(low, high), order);
+        __m256i is_free = _mm256_cmpeq_epi8(bytes, _mm256_setzero_si256());
+        __m256i text = _mm256_blendv_epi8(_mm256_add_epi8(bytes, zero_avx),
+                                          free_avx, is_free);
+        _mm256_storeu_si256((__m256i *) (out + x), text);
+    }
+#endif
+
+#ifdef __SSE2__
+    const __m128i free_sse = _mm_set1_epi8('.');
+    const __m128i zero_sse = _mm_set1_epi8('0');
+    for (; x + 16 <= width; x += 16) {
+        const __m128i *in = (const __m128i *) (owners + x);
+        __m128i low = _mm_packs_epi32(_mm_loadu_si128(in),
+                                      _mm_loadu_si128(in + 1));
+        __m128i high = _mm_packs_epi32(_mm_loadu_si128(in + 2),
+                                       _mm_loadu_si128(in + 3));
+        __m128i bytes = _mm_packus_epi16(low, high);
+        __m128i is_free = _mm_cmpeq_epi8(bytes, _mm_setzero_si128());
+        __m128i text = _mm_or_si128(
+                _mm_and_si128(is_free, free_sse),
+                _mm_andnot_si128(is_free, _mm_add_epi8(bytes, zero_sse)));
+        _mm_storeu_si128((__m128i *) (out + x), text);
+    }
+#endif
+
+    for (; x < width; x++)
+        out[x] = owners[x] == 0 ? '.' : (char) ('0' + owners[x]);
+
+    return out + width;
+}
+
+/** @brief Writes @p owner right-aligned in a column.
+ *
+ * @param owner         – zero (written as '.') or the index of the player
+ * @param column_width  – width of the column, at least the number of digits
+ * @param out           – where to write
+ */
+static void render_cell(uint32_t owner, uint32_t column_width, char *out) {
+    uint32_t i = column_width;
+    if (owner == 0) {
+        out[--i] = '.';
+    } else {
+        for (; owner > 0; owner /= 10)
+            out[--i] = (char) ('0' + owner % 10);
+    }
+    memset(out, ' ', i);
+}
+
+/** @brief Minimal number of fields of a stripe of rows rendered by a task
+ */
+#define STRIPE_FIELDS 65536
+
+/** @brief Number of stripes of rows per thread, more stripes even out
+ * the threads getting to the job at different times
+ */
+#define STRIPES_PER_THREAD 4
+
+/** @brief Structure storing the state of rendering the board
+ */
+typedef struct Render {
+    gamma_t *g;                  /**< The game */
+    char *board;                 /**< The rendered board */
+    uint32_t column_width;       /**< Width of the column of a field */
+    size_t row_width;            /**< Characters of a row,
+                                      including the newline */
+    uint32_t stripe_rows;        /**< Number of rows of a stripe */
+    const char (*table)[MAX_TABLE_DIGITS + 1]; /**< Cells of the owners,
+                                                    with a separator */
+    atomic_bool failed;          /**< Has an allocation failed */
+} Render;
+
+/** @brief Renders a single row of the board, with its newline.
+ *
+ * @param render        – the state of rendering
+ * @param y             – index of the row
+ * @param owners        – array of @ref gamma_t.width elements
+ * @param row           – where to write
+ */
+static void render_row(Render *render, uint32_t y, uint32_t *owners,
+                       char *row) {
+    gamma_t *g = render->g;
+    uint32_t column_width = render->column_width;
+    get_row_owners(g, y, owners);
+
+    if (column_width == 1) {
+        row = render_digits(owners, g->width, row);
+    } else if (column_width <= MAX_TABLE_DIGITS) {
+        // The last byte copied belongs to the next cell,
+        // the last cell is copied without it to stay within the row
+        uint32_t x = 0;
+        for (; x < g->width - 1; x++)
+            memcpy(row + (size_t) x * (column_width + 1),
+                   render->table[owners[x]], MAX_TABLE_DIGITS + 1);
+        memcpy(row + (size_t) x * (column_width + 1),
+               render->table[owners[x]], column_width);
+        row += render->row_width - 1;
+    } else {
+        for (uint32_t x = 0; x < g->width; x++) {
+            render_cell(owners[x], column_width, row);
+            row += column_width;
+            if (x < g->width - 1)
+                *row++ = ' ';
+        }
+    }
+
+    *row = '\n';
+}
+
+/** @brief Renders a stripe of rows, see @ref PoolTask.
+ */
+static void render_stripe(void *arg, uint64_t index) {
+    Render *render = arg;
+    gamma_t *g = render->g;
+    uint32_t *owners = malloc(g->width * sizeof(uint32_t));
+    if (owners == NULL) {
+        atomic_store(&render->failed, true);
+        return;
+    }
+
+    // The rows are printed from the top one
+    uint64_t first = index * render->stripe_rows;
+    uint64_t end = first + render->stripe_rows;
+    if (end > g->height)
+        end = g->height;
+    for (uint64_t i = first; i < end; i++)
+        render_row(render, g->height - 1 - i, owners,
+                   render->board + i * render->row_width);
+
+    free(owners);
+}
+
 char *gamma_board(gamma_t *g) {
     if (g == NULL)
         return NULL;
 
-    uint32_t max_player_length = number_of_digits(g->number_of_players);
+    uint64_t start = trace_begin();
+    uint32_t column_width = number_of_digits(g->number_of_players);
 
+    // Columns wider than one character are separated by a space
     uint32_t row_padding;
-    if (max_player_length == 1)
+    if (column_width == 1)
         row_padding = 0;
     else
         row_padding = 1;
 
-    uint32_t column_width = max_player_length;
-    uint32_t row_width = column_width * (g->width)
-                         + row_padding * (g->width - 1)
-                         + 1;
+    size_t row_width = (size_t) (column_width + row_padding) * g->width
+                       - row_padding + 1;
 
     char *board = malloc(row_width * g->height + 1);
-    char *board_beginning = board;
-
-    // y needs to be signed, so that decrementing zero does not overflow
-    // int32_t y would not be sufficient to store large values of
-    // g->height - 1, which is an uint64_t
-    for (int64_t y = g->height - 1; y >= 0; y--) {
-        for (uint32_t x = 0; x < g->width; x++) {
-
-            uint32_t owner = g->board[x][y].owner;
-            char *owner_str = owner_to_str(owner);
-
-            // Print with padding
-            board += sprintf(board,
-                             "%*s%s",
-                             column_width - (uint32_t) strlen(owner_str), "",
-                             owner_str);
+    if (board == NULL)
+        return NULL;
 
-            free(owner_str);
+    // For at most MAX_TABLE_DIGITS digits every cell with its separator
+    // is copied from a table as a single four-byte word
+    char table[TABLE_SIZE][MAX_TABLE_DIGITS + 1];
+    if (column_width > 1 && column_width <= MAX_TABLE_DIGITS) {
+        for (uint32_t owner = 0; owner <= g->number_of_players; owner++) {
+            render_cell(owner, column_width, table[owner]);
+            table[owner][column_width] = ' ';
+        }
+    }
 
-            if (x < g->width - 1)
-                for (uint32_t k = 0; k < row_padding; k++)
-                    board += sprintf(board, " ");
+    // A single thread and small boards render a single stripe
+    uint64_t stripes = 1;
+    if (g->threads > 1)
+        stripes = (uint64_t) g->threads * STRIPES_PER_THREAD;
+    uint64_t stripe_rows = (g->height + stripes - 1) / stripes;
+    uint64_t min_rows = (STRIPE_FIELDS + g->width - 1) / g->width;
+    if (stripe_rows < min_rows)
+        stripe_rows = min_rows;
+    if (stripe_rows > g->height)
+        stripe_rows = g->height;
 
-        }
+    Render render = {.g = g, .board = board, .column_width = column_width,
+                     .row_width = row_width, .stripe_rows = stripe_rows,
+                     .table = (const char (*)[MAX_TABLE_DIGITS + 1]) table};
+    atomic_init(&render.failed, false);
+    pool_run(g->threads, (g->height + stripe_rows - 1) / stripe_rows,
+             render_stripe, &render);
 
-        board += sprintf(board, "\n");
+    if (atomic_load(&render.failed)) {
+        free(board);
+        return NULL;
     }
 
-    *board = '\0';
+    board[row_width * g->height] = '\0';
+    STATS_ADD(g, bytes_rendered, row_width * g->height);
+    trace_end("gamma_board", start);
 
-    return board_beginning;
-}
\ No newline at end of file
+    return board;
+}
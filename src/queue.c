@@ -5,82 +5,113 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "queue.h"
-#include "types.c"
 
-struct Node;
-
-/** @brief Stores data of a single node in the queue
+/** @brief Initial number of values the buffer can hold
  */
-typedef struct NodeData {
-    Position value; /**< Value stored by this node */
-    struct NodeData *next; /**< Pointer to the next node in the queue*/
-} *Node;
-
+#define INITIAL_CAPACITY 64
 
 typedef struct QueueData {
-    Node first; /**< Pointer to the first node of the queue,
-                     NULL if the queue is empty*/
-    Node last; /**< Pointer to the last node of the queue,
-                    NULL if the queue is empty*/
+    unsigned char *values; /**< Circular buffer of the values */
+    size_t value_size;     /**< Size of a single value: 4 or 8 bytes */
+    uint64_t capacity;     /**< Number of values the buffer can hold,
+                                a power of two */
+    uint64_t first;        /**< Index of the first value in the buffer */
+    uint64_t size;         /**< Number of the values in the queue */
+#ifdef GAMMA_STATS
+    uint64_t pushes; /**< Number of values ever inserted */
+#endif
 } *Queue;
 
-Queue queue_new() {
+Queue queue_new(uint64_t max_value) {
     Queue result = calloc(1, sizeof(struct QueueData));
     if (result == NULL)
         return NULL;
 
+    result->value_size = max_value <= UINT32_MAX ? sizeof(uint32_t)
+                                                 : sizeof(uint64_t);
+    result->capacity = INITIAL_CAPACITY;
+    result->values = malloc(result->capacity * result->value_size);
+    if (result->values == NULL) {
+        free(result);
+        return NULL;
+    }
+
     return result;
 }
 
 bool queue_empty(Queue queue) {
-    // Assert that both first and last element of queue either
-    // both exist or both don't
-    assert((queue->first == NULL &&
-            queue->last == NULL) ||
-           (queue->first != NULL &&
-            queue->last != NULL));
-
-    return queue->first == NULL &&
-           queue->last == NULL;
+    return queue->size == 0;
 }
 
-void queue_insert(Queue queue, Position value) {
-    Node new_node = malloc(sizeof(struct NodeData));
-
-    new_node->value = value;
-    new_node->next = NULL;
+/** @brief Doubles the capacity of @p queue.
+ *
+ * @return False if the allocation has failed
+ *         (in which case the queue is not changed), true otherwise.
+ */
+static bool queue_grow(Queue queue) {
+    unsigned char *values = malloc(2 * queue->capacity * queue->value_size);
+    if (values == NULL)
+        return false;
+
+    // The buffer is full, so the values wrap around at the first one
+    uint64_t head = queue->capacity - queue->first;
+    memcpy(values, queue->values + queue->first * queue->value_size,
+           head * queue->value_size);
+    memcpy(values + head * queue->value_size, queue->values,
+           queue->first * queue->value_size);
+
+    free(queue->values);
+    queue->values = values;
+    queue->first = 0;
+    queue->capacity *= 2;
+    return true;
+}
 
-    if (queue_empty(queue)) {
-        queue->first = new_node;
-        queue->last = new_node;
-    } else {
-        queue->last->next = new_node;
-        queue->last = new_node;
-    }
+bool queue_insert(Queue queue, uint64_t value) {
+    if (queue->size == queue->capacity && !queue_grow(queue))
+        return false;
+
+#ifdef GAMMA_STATS
+    queue->pushes++;
+#endif
+    uint64_t index = (queue->first + queue->size) & (queue->capacity - 1);
+    if (queue->value_size == sizeof(uint32_t))
+        ((uint32_t *) queue->values)[index] = value;
+    else
+        ((uint64_t *) queue->values)[index] = value;
+    queue->size++;
+    return true;
 }
 
-Position queue_pop(Queue queue) {
+uint64_t queue_pop(Queue queue) {
     assert(!queue_empty(queue));
 
-    Node node_popped = queue->first;
-    Position result = node_popped->value;
-
-    if (queue->first == queue->last) {
-        queue->last = NULL;
-    }
-    queue->first = queue->first->next;
+    uint64_t result;
+    if (queue->value_size == sizeof(uint32_t))
+        result = ((uint32_t *) queue->values)[queue->first];
+    else
+        result = ((uint64_t *) queue->values)[queue->first];
 
-    free(node_popped);
+    queue->first = (queue->first + 1) & (queue->capacity - 1);
+    queue->size--;
     return result;
 }
 
+uint64_t queue_pushes(Queue queue) {
+#ifdef GAMMA_STATS
+    return queue->pushes;
+#else
+    (void) queue;
+    return 0;
+#endif
+}
+
 void queue_delete(Queue queue) {
     if (queue != NULL) {
-        while (!queue_empty(queue)) {
-            queue_pop(queue);
-        }
+        free(queue->values);
         free(queue);
     }
-}
\ No newline at end of file
+}
@@ -1,6 +1,9 @@
 /** @file
  * Interface for managing the queue
  *
+ * The queue stores indices (e.g. slots of the board) in a circular
+ * buffer, packed into 32 bits when the largest index allows.
+ *
  * @author Jakub Szulc <gihtub.com/j-szulc>
  */
 
@@ -15,11 +18,12 @@ typedef struct QueueData *Queue;
 
 /** @brief Allocates an empty queue.
  *
+ * @param max_value     – the largest value that will be inserted
  * @return Empty queue.
  *         i.e. pointer to the newly allocated QueueData
  *         or NULL if the allocation has failed
  */
-Queue queue_new();
+Queue queue_new(uint64_t max_value);
 
 /** @brief Checks if Queue @p queue is empty.
  *
@@ -30,9 +34,12 @@ bool queue_empty(Queue queue);
 /** @brief Insert @p value at the end of @p queue.
  *
  * @param queue         – pointer to the structure storing queue data
- * @param value         – value to append at the end of the queue
+ * @param value         – value to append at the end of the queue,
+ *                        not greater than the one given to @ref queue_new
+ * @return False if the allocation has failed
+ *         (in which case the queue is not changed), true otherwise.
  */
-void queue_insert(Queue queue, Position value);
+bool queue_insert(Queue queue, uint64_t value);
 
 /** @brief Remove the first value from @p queue.
  *
@@ -40,7 +47,14 @@ void queue_insert(Queue queue, Position value);
  * @param queue         – pointer to the structure storing queue data
  * @return The value removed from @p queue.
  */
-Position queue_pop(Queue queue);
+uint64_t queue_pop(Queue queue);
+
+/** @brief Returns the number of values ever inserted into @p queue.
+ *
+ * Always zero unless GAMMA_STATS is defined, see @ref stats.h.
+ * @param queue         – pointer to the structure storing queue data
+ */
+uint64_t queue_pushes(Queue queue);
 
 /** @brief Frees @p queue from the memory.
  *
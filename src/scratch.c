@@ -0,0 +1,89 @@
+/** @file
+ * Implementation of the scratch memory of the searches
+ *
+ * The arrays of a thread are kept in a thread-local variable
+ * and freed by the destructor of a key set for the thread.
+ * The destructor does not run for the thread calling exit,
+ * its arrays are freed by a function registered with atexit.
+ * An array only grows, a longer one replaces it, which is correct
+ * because a search zeroes the array before it ends.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "scratch.h"
+
+/** @brief Stores the scratch arrays of a single thread
+ */
+typedef struct ScratchData {
+    uint64_t *arrays[NUMBER_OF_SCRATCH_KINDS]; /**< The arrays, NULL
+                                                    until first needed */
+    uint64_t words[NUMBER_OF_SCRATCH_KINDS];   /**< Their lengths */
+} *Scratch;
+
+/** @brief Arrays of the current thread, NULL until its first search */
+static _Thread_local Scratch scratch = NULL;
+
+/** @brief Frees the arrays of a finishing thread */
+static pthread_key_t scratch_key;
+
+/** @brief Creates @ref scratch_key once */
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+
+/** @brief Has @ref scratch_key been created */
+static bool key_created = false;
+
+/** @brief Frees the arrays of a thread.
+ */
+static void scratch_release(void *released) {
+    Scratch s = released;
+    for (int i = 0; i < NUMBER_OF_SCRATCH_KINDS; i++)
+        free(s->arrays[i]);
+    free(s);
+}
+
+/** @brief Frees the arrays of the thread calling exit.
+ */
+static void release_at_exit() {
+    if (scratch != NULL) {
+        pthread_setspecific(scratch_key, NULL);
+        scratch_release(scratch);
+        scratch = NULL;
+    }
+}
+
+/** @brief Creates @ref scratch_key.
+ */
+static void create_key() {
+    key_created = pthread_key_create(&scratch_key, scratch_release) == 0;
+    if (key_created)
+        atexit(release_at_exit);
+}
+
+uint64_t *scratch_get(ScratchKind kind, uint64_t words) {
+    if (scratch == NULL) {
+        pthread_once(&key_once, create_key);
+        if (!key_created)
+            return NULL;
+
+        scratch = calloc(1, sizeof(struct ScratchData));
+        if (scratch == NULL)
+            return NULL;
+        pthread_setspecific(scratch_key, scratch);
+    }
+
+    if (scratch->words[kind] < words) {
+        // The old array is zero, so is the fresh one
+        uint64_t *array = calloc(words, sizeof(uint64_t));
+        if (array == NULL)
+            return NULL;
+
+        free(scratch->arrays[kind]);
+        scratch->arrays[kind] = array;
+        scratch->words[kind] = words;
+    }
+    return scratch->arrays[kind];
+}
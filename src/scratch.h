@@ -0,0 +1,43 @@
+/** @file
+ * Interface for the scratch memory of the searches
+ *
+ * The searches of the engine (see @ref are_in_the_same_area) mark
+ * what they have visited in arrays kept by the thread running them,
+ * not by the game. A search never writes to the game it searches,
+ * so any number of threads may search the same game at once,
+ * as long as none of them changes it.
+ *
+ * The arrays are zero when a search gets them and each search
+ * zeroes again whatever it has set, so they are allocated zeroed
+ * and never cleared as a whole.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <stdint.h>
+
+/** @brief Uses of the scratch arrays, a thread has an array for each
+ */
+typedef enum ScratchKind {
+    SCRATCH_VISITED,    /**< Bitmap of the marked slots of the board */
+    SCRATCH_ROWS,       /**< Rows filled by @ref bitboard_fill */
+    SCRATCH_REACHED,    /**< Bitmap of the components reached
+                             by @ref blocks_connected */
+    NUMBER_OF_SCRATCH_KINDS
+} ScratchKind;
+
+/** @brief Returns a scratch array of the current thread.
+ *
+ * The array is zero except for what the caller has set since
+ * it last got the array and has not zeroed yet, so the same search
+ * may get it again. It is freed when the thread finishes.
+ * @param kind          – use of the array
+ * @param words         – length of the array, in 64-bit words
+ * @return Pointer to the array or NULL if the allocation has failed.
+ */
+uint64_t *scratch_get(ScratchKind kind, uint64_t words);
+
+#endif //SCRATCH_H
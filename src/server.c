@@ -0,0 +1,455 @@
+/** @file
+ * The implementation of the server mode of the game gamma
+ *
+ * A single epoll loop serves the listening socket and all the clients.
+ * The sockets are non-blocking, each client has its own buffers:
+ * the input is split into lines once they are complete and the answers
+ * are printed to a memory stream, from which they are sent as soon as
+ * the socket accepts them. A client whose answers are not being read
+ * stops being read itself until they are.
+ *
+ * Implementation:
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "batch.h"
+
+/**@brief Longest line accepted from a client, longer ones end the connection
+ */
+#define MAX_LINE_LENGTH 4096
+
+/**@brief Number of bytes of unsent answers above which the client
+ * is not read until they are sent
+ */
+#define MAX_PENDING_OUTPUT (1 << 20)
+
+/**@brief Number of bytes read from a socket at once
+ */
+#define READ_SIZE 4096
+
+/**@brief Number of events handled by a single call of epoll_wait
+ */
+#define MAX_EVENTS 64
+
+/**@brief Milliseconds to wait before accepting again when the server
+ * has run out of descriptors or memory
+ */
+#define ACCEPT_RETRY_MS 100
+
+/**@brief Longest search of the a command, in milliseconds
+ */
+#define MAX_AI_BUDGET_MS 1000
+
+/**@brief Largest number of the fields of the board of a client,
+ * which bounds the work of the commands scanning the board (p, c and r)
+ */
+#define MAX_BOARD_FIELDS (1 << 18)
+
+/** @brief Structure storing the state of a single client
+ */
+typedef struct Client {
+    int socket;             /**< The socket of the connection */
+    gamma_t *g;             /**< The game of the client, NULL until
+                                 the B command */
+    uint32_t line;          /**< Number of the lines read */
+    char *input;            /**< Bytes read, not processed yet */
+    size_t inputLength;     /**< Number of the bytes in @p input */
+    size_t inputCapacity;   /**< Size of @p input */
+    FILE *out;              /**< Stream the answers are printed to,
+                                 NULL if there are none */
+    char *output;           /**< Contents of @p out */
+    size_t outputLength;    /**< Length of @p output after the last flush */
+    size_t outputSent;      /**< Number of the bytes of @p output sent */
+    bool finished;          /**< Has the client closed its side */
+    uint32_t events;        /**< Events the client is registered for */
+    struct Client *previous; /**< Previous client of the list */
+    struct Client *next;    /**< Next client of the list */
+} Client;
+
+/** @brief Set by the signal handler to stop the server
+ */
+static volatile sig_atomic_t stopping = 0;
+
+/** @brief Stops the server
+ */
+static void stop(int signal) {
+    (void) signal;
+    stopping = 1;
+}
+
+/** @brief Frees the client and closes its connection
+ * @param epoll         - the epoll instance
+ * @param clients       - the list of the clients
+ * @param client        - the client
+ */
+static void disconnect(int epoll, Client **clients, Client *client) {
+    epoll_ctl(epoll, EPOLL_CTL_DEL, client->socket, NULL);
+    close(client->socket);
+
+    if (client->previous != NULL)
+        client->previous->next = client->next;
+    else
+        *clients = client->next;
+    if (client->next != NULL)
+        client->next->previous = client->previous;
+
+    if (client->out != NULL)
+        fclose(client->out);
+    free(client->output);
+    free(client->input);
+    gamma_delete(client->g);
+    free(client);
+}
+
+/** @brief Checks if a command is cheap enough for the server
+ * The commands run synchronously in the only thread of the server,
+ * so a long one would stall all the other clients. Rejects the B command
+ * with a board of more than MAX_BOARD_FIELDS fields and the a command
+ * with a budget above MAX_AI_BUDGET_MS. The c command only checks
+ * the part of its rectangle lying on the board.
+ * @param command       - a one-letter command
+ * @param args          - array of arguments for the command
+ * @param numberOfArgs  - length of @p args array
+ * @return false if the command is too expensive, true otherwise
+ */
+static bool withinLimits(char command, uint32_t *args, uint32_t numberOfArgs) {
+    if (command == 'a' && numberOfArgs == 3)
+        return args[1] <= MAX_AI_BUDGET_MS;
+    if (command == 'B' && numberOfArgs == 4)
+        return (uint64_t) args[0] * args[1] <= MAX_BOARD_FIELDS;
+    return true;
+}
+
+/** @brief Processes a single line of the input of a client
+ * Prints the answer, like the batch mode of gamma_main
+ * with the errors printed to the same stream.
+ * @param client        - the client
+ * @param line          - the line, without the newline
+ */
+static void processLine(Client *client, char *line) {
+    client->line++;
+    if (*line == '\0' || *line == '#')
+        return;
+
+    char command;
+    uint32_t args[MAX_NUMBER_OF_ARGS];
+    uint32_t numberOfArgs;
+    bool correct = parseCommand(line, &command, args, &numberOfArgs);
+
+    if (correct && client->g != NULL) {
+        correct = withinLimits(command, args, numberOfArgs) &&
+                  batch(client->g, command, args, numberOfArgs, client->out);
+    } else if (correct && command == 'B' && numberOfArgs == 4 &&
+               withinLimits(command, args, numberOfArgs) &&
+               (client->g = gamma_new(args[0], args[1],
+                                      args[2], args[3])) != NULL) {
+        fprintf(client->out, "OK %u\n", client->line);
+    } else {
+        // The interactive mode needs a terminal
+        correct = false;
+    }
+
+    if (!correct)
+        fprintf(client->out, "ERROR %u\n", client->line);
+}
+
+/** @brief Returns the number of the bytes of the answers not sent yet
+ */
+static size_t pendingOutput(Client *client) {
+    return client->outputLength - client->outputSent;
+}
+
+/** @brief Processes the complete lines of the input of a client
+ * Stops when the unsent answers grow above MAX_PENDING_OUTPUT.
+ * After the client has closed its side the rest of the input
+ * is processed as the last line.
+ * @param client        - the client
+ * @return false if the allocation has failed, true otherwise
+ */
+static bool processInput(Client *client) {
+    size_t processed = 0;
+    while (processed < client->inputLength &&
+           pendingOutput(client) <= MAX_PENDING_OUTPUT) {
+        char *line = client->input + processed;
+        size_t rest = client->inputLength - processed;
+        char *newline = memchr(line, '\n', rest);
+        if (newline == NULL && !client->finished)
+            break;
+
+        if (client->out == NULL) {
+            client->out = open_memstream(&client->output,
+                                         &client->outputLength);
+            if (client->out == NULL)
+                return false;
+        }
+
+        if (newline != NULL) {
+            *newline = '\0';
+            processed += newline - line + 1;
+        } else {
+            // The input buffer always has room for the terminating zero
+            line[rest] = '\0';
+            processed = client->inputLength;
+        }
+        processLine(client, line);
+        fflush(client->out);
+    }
+
+    memmove(client->input, client->input + processed,
+            client->inputLength - processed);
+    client->inputLength -= processed;
+    return true;
+}
+
+/** @brief Reads once from the socket of a client
+ * @param client        - the client
+ * @return false if the connection is broken
+ * or the allocation has failed, true otherwise
+ */
+static bool readInput(Client *client) {
+    if (client->inputCapacity - client->inputLength < READ_SIZE + 1) {
+        size_t capacity = 2 * client->inputCapacity;
+        if (capacity < client->inputLength + READ_SIZE + 1)
+            capacity = client->inputLength + READ_SIZE + 1;
+        char *input = realloc(client->input, capacity);
+        if (input == NULL)
+            return false;
+        client->input = input;
+        client->inputCapacity = capacity;
+    }
+
+    ssize_t length = read(client->socket,
+                          client->input + client->inputLength, READ_SIZE);
+    if (length > 0)
+        client->inputLength += length;
+    else if (length == 0)
+        client->finished = true;
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        return false;
+    return true;
+}
+
+/** @brief Checks if the input of a client holds a line to process
+ */
+static bool hasLine(Client *client) {
+    return client->inputLength > 0 &&
+           (client->finished ||
+            memchr(client->input, '\n', client->inputLength) != NULL);
+}
+
+/** @brief Sends as much of the answers of a client as the socket accepts
+ * @param client        - the client
+ * @return false if the connection is broken, true otherwise
+ */
+static bool writeOutput(Client *client) {
+    while (pendingOutput(client) > 0) {
+        ssize_t length = send(client->socket,
+                              client->output + client->outputSent,
+                              pendingOutput(client), MSG_NOSIGNAL);
+        if (length >= 0)
+            client->outputSent += length;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return true;
+        else if (errno != EINTR)
+            return false;
+    }
+
+    // Everything has been sent, start the next answers from scratch
+    if (client->out != NULL) {
+        fclose(client->out);
+        free(client->output);
+        client->out = NULL;
+        client->output = NULL;
+        client->outputLength = 0;
+        client->outputSent = 0;
+    }
+    return true;
+}
+
+/** @brief Handles the events of a client
+ * Reads, answers and registers the client for the events
+ * it's waiting for. The events are level-triggered, so a client
+ * with more to read is served again by the next epoll_wait.
+ * @param epoll         - the epoll instance
+ * @param client        - the client
+ * @return false if the client is to be disconnected, true otherwise
+ */
+static bool serveClient(int epoll, Client *client) {
+    if (!client->finished && pendingOutput(client) <= MAX_PENDING_OUTPUT &&
+        !readInput(client))
+        return false;
+
+    // Answering stops at too many unsent answers,
+    // go on once some of them have been sent
+    do {
+        if (!processInput(client) || !writeOutput(client))
+            return false;
+    } while (pendingOutput(client) <= MAX_PENDING_OUTPUT && hasLine(client));
+
+    if (!hasLine(client) && client->inputLength > MAX_LINE_LENGTH)
+        return false;
+    if (client->finished && client->inputLength == 0 &&
+        pendingOutput(client) == 0)
+        return false;
+
+    uint32_t events = 0;
+    if (!client->finished && pendingOutput(client) <= MAX_PENDING_OUTPUT)
+        events |= EPOLLIN;
+    if (pendingOutput(client) > 0)
+        events |= EPOLLOUT;
+    if (events != client->events) {
+        struct epoll_event event = {.events = events, .data.ptr = client};
+        if (epoll_ctl(epoll, EPOLL_CTL_MOD, client->socket, &event) != 0)
+            return false;
+        client->events = events;
+    }
+    return true;
+}
+
+/** @brief Accepts all the waiting connections
+ * When the server runs out of descriptors or memory, the waiting
+ * connections stay in the queue and the listener is left readable.
+ * The listener is then unregistered from EPOLLIN, so that the loop
+ * does not spin, until @ref resumeAccepting.
+ * @param epoll         - the epoll instance
+ * @param listener      - the listening socket
+ * @param clients       - the list of the clients
+ * @return false if the listener has been paused, true otherwise
+ */
+static bool acceptClients(int epoll, int listener, Client **clients) {
+    while (true) {
+        int socket = accept4(listener, NULL, NULL,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EMFILE && errno != ENFILE &&
+                errno != ENOBUFS && errno != ENOMEM)
+                return true;
+
+            struct epoll_event event = {.events = 0, .data.ptr = NULL};
+            epoll_ctl(epoll, EPOLL_CTL_MOD, listener, &event);
+            return false;
+        }
+
+        Client *client = calloc(1, sizeof(Client));
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = client};
+        if (client == NULL ||
+            epoll_ctl(epoll, EPOLL_CTL_ADD, socket, &event) != 0) {
+            free(client);
+            close(socket);
+            continue;
+        }
+
+        client->socket = socket;
+        client->events = EPOLLIN;
+        client->next = *clients;
+        if (*clients != NULL)
+            (*clients)->previous = client;
+        *clients = client;
+    }
+}
+
+/** @brief Registers the paused listener for EPOLLIN again
+ * @param epoll         - the epoll instance
+ * @param listener      - the listening socket
+ * @return false if the listener is still paused, true otherwise
+ */
+static bool resumeAccepting(int epoll, int listener) {
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    return epoll_ctl(epoll, EPOLL_CTL_MOD, listener, &event) == 0;
+}
+
+/** @brief Creates the listening socket
+ * @param path          - path of the socket
+ * @return The socket or -1 if it could not be created.
+ */
+static int listenOn(const char *path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    // Replace only a socket, never a regular file
+    struct stat status;
+    if (lstat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+        unlink(path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          0);
+    if (listener < 0)
+        return -1;
+    if (bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+bool server(const char *path) {
+    int listener = listenOn(path);
+    if (listener < 0) {
+        perror(path);
+        return false;
+    }
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    if (epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) != 0) {
+        perror("epoll");
+        if (epoll >= 0)
+            close(epoll);
+        close(listener);
+        unlink(path);
+        return false;
+    }
+
+    // Without SA_RESTART the signals interrupt epoll_wait
+    struct sigaction action = {.sa_handler = stop};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    Client *clients = NULL;
+    struct epoll_event events[MAX_EVENTS];
+    bool accepting = true;
+    while (!stopping) {
+        // A paused listener is retried after a client has been served,
+        // which may have freed its descriptor, or after a while
+        int ready = epoll_wait(epoll, events, MAX_EVENTS,
+                               accepting ? -1 : ACCEPT_RETRY_MS);
+        if (!accepting)
+            accepting = resumeAccepting(epoll, listener);
+        for (int i = 0; i < ready; i++) {
+            Client *client = events[i].data.ptr;
+            if (client == NULL)
+                accepting = acceptClients(epoll, listener, &clients);
+            else if (!serveClient(epoll, client))
+                disconnect(epoll, &clients, client);
+        }
+    }
+
+    while (clients != NULL)
+        disconnect(epoll, &clients, clients);
+    close(epoll);
+    close(listener);
+    unlink(path);
+    return true;
+}
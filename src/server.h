@@ -0,0 +1,31 @@
+/** @file
+ * The interface of the server mode of the game gamma
+ *
+ * Implementation:
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+
+/** @brief Server mode of the gamma game
+ * Listens on a Unix domain socket and plays a separate game
+ * with each client. A client speaks the batch mode language:
+ * the first correct line must create a game with the B command,
+ * the following ones are batch mode commands (see @ref batch).
+ * The answers and the "OK"/"ERROR" lines are sent back to the client,
+ * the game ends when the client closes the connection.
+ * Serves all the clients in a single thread with non-blocking I/O,
+ * runs until SIGINT or SIGTERM is received. The commands run
+ * synchronously, so a client's command delays all the other clients:
+ * the B command with a board of more than 2^18 fields and the a command
+ * with a budget above a second are rejected with ERROR.
+ * @param path      - path of the socket, an existing socket
+ *                    (e.g. left by a killed server) is replaced
+ * @return false if the socket could not be set up, true otherwise
+ */
+bool server(const char *path);
+
+#endif //SERVER_H
@@ -0,0 +1,185 @@
+/** @file
+ * Implementation of the published states of a game
+ *
+ * Replaced states are reclaimed by epochs. Each publish starts
+ * a new epoch and retires the replaced state with the number
+ * of the epoch which has just ended. A reader stores the number
+ * of the current epoch before it reads the published state,
+ * so a reader which might have got a retired state has stored
+ * a number not greater than the one of the state. A state is freed
+ * once all the pinning readers have stored greater numbers.
+ *
+ * The readers are linked into a list with compare-and-swap
+ * and are never removed from it until @ref gamma_snapshots_delete;
+ * a freed reader is taken over by the next one created.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "snapshot.h"
+#include "memory.h"
+
+/** @brief Epoch of a reader not holding any pinned state
+ */
+#define UNPINNED UINT64_MAX
+
+/** @brief Stores the state of a single reader
+ */
+typedef struct SnapshotReaderData {
+    atomic_uint_fast64_t epoch;        /**< Epoch in which the reader pinned
+                                            its state, @ref UNPINNED
+                                            if it holds none */
+    atomic_bool in_use;                /**< Has the reader been created
+                                            and not freed */
+    struct SnapshotsData *snapshots;   /**< States the reader pins */
+    struct SnapshotReaderData *next;   /**< Next reader of the list */
+} *SnapshotReader;
+
+/** @brief Stores a replaced state not freed yet
+ */
+typedef struct RetiredData {
+    gamma_t *state;            /**< The state */
+    uint64_t epoch;            /**< Last epoch in which it was published */
+    struct RetiredData *next;  /**< State replaced before this one */
+} *Retired;
+
+/** @brief Stores the published states of a single game
+ */
+typedef struct SnapshotsData {
+    gamma_t *game;                    /**< The game being played */
+    _Atomic(gamma_t *) current;       /**< The latest published state */
+    atomic_uint_fast64_t epoch;       /**< Number of the current epoch */
+    _Atomic(SnapshotReader) readers;  /**< List of all the readers */
+    Retired retired;                  /**< Replaced states, from the latest
+                                           one, only used by publishing */
+} *Snapshots;
+
+Snapshots gamma_snapshots_new(gamma_t *g) {
+    if (g == NULL)
+        return NULL;
+
+    Snapshots result = malloc(sizeof(struct SnapshotsData));
+    gamma_t *state = gamma_fork(g);
+    if (result == NULL || state == NULL) {
+        free(result);
+        gamma_delete(state);
+        return NULL;
+    }
+
+    result->game = g;
+    atomic_init(&result->current, state);
+    atomic_init(&result->epoch, 0);
+    atomic_init(&result->readers, NULL);
+    result->retired = NULL;
+    return result;
+}
+
+/** @brief Returns the epoch of the oldest pinned state.
+ *
+ * @return The least epoch stored by a reader,
+ *         @ref UNPINNED if no reader holds a pinned state.
+ */
+static uint64_t oldest_pinned(Snapshots snapshots) {
+    uint64_t result = UNPINNED;
+    for (SnapshotReader r = atomic_load(&snapshots->readers); r != NULL;
+         r = r->next) {
+        uint64_t epoch = atomic_load(&r->epoch);
+        if (epoch < result)
+            result = epoch;
+    }
+    return result;
+}
+
+/** @brief Frees the retired states @p retired and the ones replaced before.
+ */
+static void free_retired(Retired retired) {
+    while (retired != NULL) {
+        Retired next = retired->next;
+        gamma_delete(retired->state);
+        free(retired);
+        retired = next;
+    }
+}
+
+bool gamma_snapshots_publish(Snapshots snapshots) {
+    Retired retired = malloc(sizeof(struct RetiredData));
+    gamma_t *state = gamma_fork(snapshots->game);
+    if (retired == NULL || state == NULL) {
+        free(retired);
+        gamma_delete(state);
+        return false;
+    }
+
+    retired->state = atomic_exchange(&snapshots->current, state);
+    retired->epoch = atomic_fetch_add(&snapshots->epoch, 1);
+    retired->next = snapshots->retired;
+    snapshots->retired = retired;
+
+    // The list goes from the latest epoch, so the states no reader
+    // can have pinned form its tail
+    uint64_t oldest = oldest_pinned(snapshots);
+    Retired *link = &snapshots->retired;
+    while (*link != NULL && (*link)->epoch >= oldest)
+        link = &(*link)->next;
+    free_retired(*link);
+    *link = NULL;
+    return true;
+}
+
+void gamma_snapshots_delete(Snapshots snapshots) {
+    if (snapshots == NULL)
+        return;
+
+    SnapshotReader r = atomic_load(&snapshots->readers);
+    while (r != NULL) {
+        SnapshotReader next = r->next;
+        free(r);
+        r = next;
+    }
+    gamma_delete(atomic_load(&snapshots->current));
+    free_retired(snapshots->retired);
+    free(snapshots);
+}
+
+SnapshotReader gamma_snapshot_reader_new(Snapshots snapshots) {
+    if (snapshots == NULL)
+        return NULL;
+
+    for (SnapshotReader r = atomic_load(&snapshots->readers); r != NULL;
+         r = r->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&r->in_use, &expected, true))
+            return r;
+    }
+
+    SnapshotReader result = malloc(sizeof(struct SnapshotReaderData));
+    if (result == NULL)
+        return NULL;
+
+    atomic_init(&result->epoch, UNPINNED);
+    atomic_init(&result->in_use, true);
+    result->snapshots = snapshots;
+    result->next = atomic_load(&snapshots->readers);
+    while (!atomic_compare_exchange_weak(&snapshots->readers, &result->next,
+                                         result));
+    return result;
+}
+
+gamma_t *gamma_snapshot_pin(SnapshotReader reader) {
+    Snapshots snapshots = reader->snapshots;
+    atomic_store(&reader->epoch, atomic_load(&snapshots->epoch));
+    return atomic_load(&snapshots->current);
+}
+
+void gamma_snapshot_unpin(SnapshotReader reader) {
+    atomic_store(&reader->epoch, UNPINNED);
+}
+
+void gamma_snapshot_reader_delete(SnapshotReader reader) {
+    if (reader != NULL) {
+        gamma_snapshot_unpin(reader);
+        atomic_store(&reader->in_use, false);
+    }
+}
@@ -0,0 +1,97 @@
+/** @file
+ * Interface for reading a game while another thread plays it
+ *
+ * The thread playing the game publishes its state with
+ * @ref gamma_snapshots_publish after the moves it wants to be seen.
+ * A published state is a fork of the game (see @ref gamma_fork):
+ * it shares all the pages with the game and the game duplicates
+ * the pages it changes afterwards, so the published state never changes.
+ *
+ * A reader pins the latest state with @ref gamma_snapshot_pin,
+ * queries it with any of the functions which don't change the game
+ * (@ref gamma_busy_fields, @ref gamma_free_fields, @ref gamma_board, ...)
+ * and unpins it with @ref gamma_snapshot_unpin. Pinning and unpinning
+ * take no lock, and publishing never waits for the readers:
+ * a replaced state is freed by a later publish, once no reader
+ * can have it pinned.
+ *
+ * Implementation:
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include "types.h"
+
+/** @brief Stores the published states of a single game.
+ */
+typedef struct SnapshotsData *Snapshots;
+
+/** @brief Stores the state of a single reader.
+ */
+typedef struct SnapshotReaderData *SnapshotReader;
+
+/** @brief Starts publishing the states of a game.
+ *
+ * Publishes the current state of the game.
+ * @param g             – pointer to the structure storing the game state
+ * @return Pointer to the published states or NULL if @p g == NULL
+ *         or the allocation has failed.
+ */
+Snapshots gamma_snapshots_new(gamma_t *g);
+
+/** @brief Publishes the current state of the game.
+ *
+ * Readers pinning a state from now on get this one.
+ * Frees the states no reader can have pinned anymore.
+ * Must not be called by two threads at once.
+ * @param snapshots     – the published states of the game
+ * @return False if the allocation has failed (in which case
+ *         the previous state stays published), true otherwise.
+ */
+bool gamma_snapshots_publish(Snapshots snapshots);
+
+/** @brief Frees the published states.
+ *
+ * The game itself is not freed. All the readers must have been freed.
+ * Does nothing if @p snapshots == NULL.
+ * @param snapshots     – the published states of the game
+ */
+void gamma_snapshots_delete(Snapshots snapshots);
+
+/** @brief Creates a reader of the published states.
+ *
+ * A reader may only be used by one thread at a time.
+ * @param snapshots     – the published states of the game
+ * @return Pointer to the reader or NULL if @p snapshots == NULL
+ *         or the allocation has failed.
+ */
+SnapshotReader gamma_snapshot_reader_new(Snapshots snapshots);
+
+/** @brief Pins the latest published state.
+ *
+ * The state stays valid until @ref gamma_snapshot_unpin.
+ * It must not be changed or freed, but any number of readers
+ * may query it at once (see @ref scratch.h).
+ * @param reader        – reader not holding any pinned state
+ * @return Pointer to the structure storing the game state.
+ */
+gamma_t *gamma_snapshot_pin(SnapshotReader reader);
+
+/** @brief Unpins the state pinned by a reader.
+ *
+ * @param reader        – reader holding a pinned state
+ */
+void gamma_snapshot_unpin(SnapshotReader reader);
+
+/** @brief Frees a reader.
+ *
+ * Unpins its state if it holds any.
+ * Does nothing if @p reader == NULL.
+ * @param reader        – reader created by @ref gamma_snapshot_reader_new
+ */
+void gamma_snapshot_reader_delete(SnapshotReader reader);
+
+#endif //SNAPSHOT_H
@@ -0,0 +1,27 @@
+/** @file
+ * Implementation of the counters of the work done by the engine
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include "stats.h"
+
+#ifdef GAMMA_STATS
+void stats_load(GammaCounters *counters, GammaStats *out) {
+    out->bfs_runs = atomic_load(&counters->bfs_runs);
+    out->cells_visited = atomic_load(&counters->cells_visited);
+    out->queue_pushes = atomic_load(&counters->queue_pushes);
+    out->owner_changes = atomic_load(&counters->owner_changes);
+    out->trial_validations = atomic_load(&counters->trial_validations);
+    out->bytes_rendered = atomic_load(&counters->bytes_rendered);
+}
+
+void stats_store(GammaCounters *counters, const GammaStats *values) {
+    atomic_store(&counters->bfs_runs, values->bfs_runs);
+    atomic_store(&counters->cells_visited, values->cells_visited);
+    atomic_store(&counters->queue_pushes, values->queue_pushes);
+    atomic_store(&counters->owner_changes, values->owner_changes);
+    atomic_store(&counters->trial_validations, values->trial_validations);
+    atomic_store(&counters->bytes_rendered, values->bytes_rendered);
+}
+#endif
@@ -0,0 +1,76 @@
+/** @file
+ * Counters of the work done by the engine
+ *
+ * The counters are compiled in only if GAMMA_STATS is defined
+ * (cmake -DGAMMA_STATS=ON), otherwise @ref STATS_ADD expands
+ * to nothing and the game state does not store them at all.
+ *
+ * Any number of threads may search a game at once (see @ref scratch.h),
+ * so the game keeps the counters in atomic variables.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/** @brief Structure storing the counters of a single game
+ *
+ * A fork of a game (see @ref gamma_fork) starts with
+ * a copy of the counters of the original game.
+ */
+typedef struct GammaStats {
+    uint64_t bfs_runs;          /**< Breadth-first searches started,
+                                     including collecting an area */
+    uint64_t cells_visited;     /**< Fields visited by the searches */
+    uint64_t queue_pushes;      /**< Positions inserted into their queues */
+    uint64_t owner_changes;     /**< Changes of the owner of a field */
+    uint64_t trial_validations; /**< Moves validated against
+                                     the area limit */
+    uint64_t bytes_rendered;    /**< Characters of the printed boards */
+} GammaStats;
+
+#ifdef GAMMA_STATS
+/** @brief Structure storing the counters inside the game state
+ *
+ * Has the fields of @ref GammaStats, updated atomically.
+ */
+typedef struct GammaCounters {
+    atomic_uint_fast64_t bfs_runs;          /**< See @ref GammaStats */
+    atomic_uint_fast64_t cells_visited;     /**< See @ref GammaStats */
+    atomic_uint_fast64_t queue_pushes;      /**< See @ref GammaStats */
+    atomic_uint_fast64_t owner_changes;     /**< See @ref GammaStats */
+    atomic_uint_fast64_t trial_validations; /**< See @ref GammaStats */
+    atomic_uint_fast64_t bytes_rendered;    /**< See @ref GammaStats */
+} GammaCounters;
+
+/** @brief Adds @p n to the counter @p counter of the game @p g.
+ *
+ * The counters only count, so no ordering is needed.
+ */
+#define STATS_ADD(g, counter, n) \
+    atomic_fetch_add_explicit(&(g)->stats.counter, (n), memory_order_relaxed)
+
+/** @brief Reads the counters of a game.
+ *
+ * @param counters      – the counters of the game
+ * @param[out] out      – where to store their values
+ */
+void stats_load(GammaCounters *counters, GammaStats *out);
+
+/** @brief Sets the counters of a game.
+ *
+ * @param counters      – the counters of the game
+ * @param values        – their new values
+ */
+void stats_store(GammaCounters *counters, const GammaStats *values);
+#else
+/** @brief Counters are compiled out, does nothing.
+ */
+#define STATS_ADD(g, counter, n) ((void) 0)
+#endif
+
+#endif //STATS_H
@@ -0,0 +1,200 @@
+/** @file
+ * Implementation of the tracing interface
+ *
+ * Each thread appends its spans to its own ring buffer, so recording
+ * a span never waits for another thread. The buffers are linked into
+ * a list with compare-and-swap and are never removed from it until
+ * @ref trace_stop; the buffer of a finished thread is released
+ * and taken over by the next thread that starts tracing. A thread
+ * still holding a buffer of an earlier tracing session, freed by
+ * @ref trace_stop, takes a new one.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "trace.h"
+
+/** @brief Number of the most recent spans kept for each thread
+ */
+#define RING_SIZE 4096
+
+/** @brief Stores a single span
+ */
+typedef struct TraceEvent {
+    const char *name;  /**< Name of the span */
+    uint64_t start;    /**< Start time in nanoseconds */
+    uint64_t duration; /**< Duration in nanoseconds */
+} TraceEvent;
+
+/** @brief Stores the spans of a single thread
+ */
+typedef struct RingData {
+    TraceEvent events[RING_SIZE]; /**< The most recent spans, the span
+                                       number i is events[i % RING_SIZE] */
+    uint64_t written;             /**< Number of spans ever written */
+    uint32_t thread;              /**< Number shown as the thread id */
+    atomic_bool in_use;           /**< Is the buffer owned by a thread */
+    struct RingData *next;        /**< Next buffer of the list */
+} *Ring;
+
+/** @brief Is tracing on */
+static atomic_bool enabled = false;
+
+/** @brief List of all the buffers */
+static _Atomic(Ring) rings = NULL;
+
+/** @brief Number of the buffers in @ref rings */
+static atomic_uint_fast32_t number_of_rings = 0;
+
+/** @brief Number of the current tracing session */
+static atomic_uint_fast64_t session = 0;
+
+/** @brief Buffer of the current thread, NULL until its first span */
+static _Thread_local Ring ring = NULL;
+
+/** @brief Tracing session @ref ring belongs to, it's valid only
+ * during that session */
+static _Thread_local uint64_t ring_session = 0;
+
+/** @brief Releases the buffer of a finishing thread */
+static pthread_key_t ring_key;
+
+/** @brief File the trace is written to */
+static FILE *output = NULL;
+
+/** @brief Time tracing was turned on, the trace starts at zero */
+static uint64_t epoch;
+
+/** @brief Returns the current time in nanoseconds.
+ */
+static uint64_t now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+}
+
+/** @brief Gives the buffer back when its thread finishes.
+ */
+static void ring_release(void *released) {
+    atomic_store(&((Ring) released)->in_use, false);
+}
+
+/** @brief Returns the buffer of the current thread.
+ *
+ * Takes over a released buffer or allocates a new one.
+ * @return Pointer to the buffer or NULL if the allocation has failed.
+ */
+static Ring ring_acquire() {
+    for (Ring r = atomic_load(&rings); r != NULL; r = r->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&r->in_use, &expected, true))
+            return r;
+    }
+
+    Ring result = calloc(1, sizeof(struct RingData));
+    if (result == NULL)
+        return NULL;
+
+    atomic_init(&result->in_use, true);
+    result->thread = atomic_fetch_add(&number_of_rings, 1) + 1;
+    result->next = atomic_load(&rings);
+    while (!atomic_compare_exchange_weak(&rings, &result->next, result));
+
+    return result;
+}
+
+bool trace_start(const char *path) {
+    if (output != NULL)
+        return true;
+
+    output = fopen(path, "w");
+    if (output == NULL || pthread_key_create(&ring_key, ring_release) != 0) {
+        if (output != NULL)
+            fclose(output);
+        output = NULL;
+        return false;
+    }
+
+    epoch = now();
+    atomic_fetch_add(&session, 1);
+    atomic_store(&enabled, true);
+    atexit(trace_stop);
+    return true;
+}
+
+/** @brief Writes the spans of a single buffer, from the oldest one.
+ *
+ * @param r             – the buffer
+ * @param first         – true if no span has been written yet
+ * @return False if any span has been written, @p first otherwise.
+ */
+static bool ring_write(Ring r, bool first) {
+    uint64_t begin = r->written > RING_SIZE ? r->written - RING_SIZE : 0;
+    for (uint64_t i = begin; i < r->written; i++) {
+        TraceEvent *event = &r->events[i % RING_SIZE];
+        fprintf(output, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                        "\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",", event->name, r->thread,
+                (double) (event->start - epoch) / 1000,
+                (double) event->duration / 1000);
+        first = false;
+    }
+    return first;
+}
+
+void trace_stop() {
+    if (output == NULL)
+        return;
+    atomic_store(&enabled, false);
+
+    fprintf(output, "{\"traceEvents\":[");
+    bool first = true;
+    Ring r = atomic_exchange(&rings, NULL);
+    while (r != NULL) {
+        first = ring_write(r, first);
+        Ring next = r->next;
+        free(r);
+        r = next;
+    }
+    fprintf(output, "\n]}\n");
+
+    fclose(output);
+    output = NULL;
+    ring = NULL;
+    pthread_key_delete(ring_key);
+}
+
+uint64_t trace_begin() {
+    if (atomic_load_explicit(&enabled, memory_order_relaxed))
+        return now();
+    else
+        return 0;
+}
+
+void trace_end(const char *name, uint64_t start) {
+    // Synchronizes with trace_start, so that the current session is seen
+    if (start == 0 || !atomic_load_explicit(&enabled, memory_order_acquire))
+        return;
+
+    uint64_t current = atomic_load_explicit(&session, memory_order_relaxed);
+    if (ring == NULL || ring_session != current) {
+        ring = ring_acquire();
+        if (ring == NULL)
+            return;
+        ring_session = current;
+        pthread_setspecific(ring_key, ring);
+    }
+
+    TraceEvent *event = &ring->events[ring->written % RING_SIZE];
+    event->name = name;
+    event->start = start;
+    event->duration = now() - start;
+    ring->written++;
+}
@@ -0,0 +1,54 @@
+/** @file
+ * Interface for tracing the time spent in the engine
+ *
+ * When tracing is on, every span (a call of an engine function,
+ * a command, a render) is stored in a ring buffer of the thread
+ * executing it. At the exit all the buffers are written to a file
+ * in the trace event format, which can be opened in a trace viewer
+ * (chrome://tracing, Perfetto). Only the most recent events
+ * of each thread are kept.
+ *
+ * When tracing is off, a span costs a single load of a flag.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Turns tracing on.
+ *
+ * The trace is written to @p path by @ref trace_stop,
+ * which is called automatically at the exit.
+ * Does nothing if tracing is already on.
+ * @param path          – path of the file to write the trace to
+ * @return False if the file could not be opened, true otherwise.
+ */
+bool trace_start(const char *path);
+
+/** @brief Writes the trace and turns tracing off.
+ *
+ * Must not be called while other threads are still tracing.
+ * Does nothing if tracing is off.
+ */
+void trace_stop();
+
+/** @brief Starts a span.
+ *
+ * @return Value to be passed to @ref trace_end,
+ *         zero if tracing is off.
+ */
+uint64_t trace_begin();
+
+/** @brief Ends a span and records it.
+ *
+ * Does nothing if @p start == 0.
+ * @param name          – name of the span, must be a string literal
+ * @param start         – value returned by @ref trace_begin
+ */
+void trace_end(const char *name, uint64_t start);
+
+#endif //TRACE_H
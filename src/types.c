@@ -7,17 +7,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "types.h"
-
-struct FieldData;
-
-typedef struct FieldData *Field;
-
-typedef struct FieldData {
-    uint32_t owner;       /**< Either zero (in which case the field is free)
-                               or index of the player whose pawn is there */
-    bool bfs_flag;        /**< Temporary flag used by @ref bfs
-                               and @ref bfs_visit_field */
-} FieldData;
+#include "frontier.h"
+#include "pages.h"
+#include "stats.h"
 
 typedef struct OwnerData {
     bool golden_move_used; /**< Has this player already used the golden move */
@@ -26,21 +18,84 @@ typedef struct OwnerData {
     int64_t busy_areas;    /**< How many areas do the fields
                                 owned by this real player form.
                                 For the fake player it's always 0.*/
+    Frontier frontier;     /**< Free fields neighbouring this real player,
+                                NULL until the first one appears.
+                                For the fake player it's always NULL. */
+    uint32_t first_area;   /**< Id of the first area of this real player
+                                in @ref gamma_t.areas, zero if none */
 } OwnerData;
 
 typedef OwnerData *Owner;
 
+typedef struct AreaData {
+    uint32_t owner;        /**< Player owning the area,
+                                zero if the id is unused */
+    uint32_t previous;     /**< Id of the previous area of the owner,
+                                zero for the first one */
+    uint32_t next;         /**< Id of the next area of the owner,
+                                or of the next unused id if the id
+                                is unused, zero for the last one */
+    uint64_t size;         /**< Number of the fields of the area */
+    uint32_t min_x;        /**< Smallest column of its fields */
+    uint32_t min_y;        /**< Smallest row of its fields */
+    uint32_t max_x;        /**< Largest column of its fields */
+    uint32_t max_y;        /**< Largest row of its fields */
+} AreaData;
+
+typedef AreaData *Area;
+
 typedef struct gamma {
     uint32_t width;              /**< Width of the board */
     uint32_t height;             /**< Height of the board */
     uint32_t max_areas;          /**< Maximal number of areas
                                       player is allowed to have */
-    FieldData **board;           /**< FieldData for each field of the board
-                                     To access FieldData for (x,y)
-                                     execute board[x][y] */
-    OwnerData *owners;           /**< Player data for each owner
-                                     (size: @p number_of_player + 1) */
+    Pages board;                 /**< Owner of each field of the board
+                                      and of the wall around it,
+                                      shared copy-on-write with forks.
+                                      Owner of (x,y) has index
+                                      @ref slot */
+    uint32_t owner_bits;         /**< Width of the owners in @p board:
+                                      8, 16 or 32, the narrowest one
+                                      fitting @p number_of_players */
+    uint64_t stride;             /**< Number of slots of a row
+                                      of @p board, a power of two
+                                      greater than @p width */
+    int64_t neighbour_offsets[5]; /**< Differences between the slots
+                                       of the neighbours of a field
+                                       and its slot: east, north, west,
+                                       south and the field itself */
+    Pages rows;                  /**< Bitboards of the owners,
+                                  see @ref bitboard.h, shared
+                                  copy-on-write with forks,
+                                  NULL if the board is too wide */
+    Pages blocks;                /**< Components of each block,
+                                  see @ref blocks.h, shared
+                                  copy-on-write with forks,
+                                  NULL if the board has bitboards */
+    Pages labels;                /**< Id of the area of each slot
+                                  of @p board, zero for the free
+                                  fields and the wall,
+                                  shared copy-on-write with forks */
+    Pages areas;                 /**< AreaData for each area id,
+                                  shared copy-on-write with forks,
+                                  id zero is never used */
+    uint32_t free_areas;         /**< First unused id released
+                                  by a merge or a capture,
+                                  zero if none */
+    uint32_t next_area;          /**< Smallest id never used */
+    Pages owners;                /**< OwnerData for each owner
+                                      (size: @p number_of_player + 1),
+                                      shared copy-on-write with forks */
     uint32_t number_of_players;  /**< Number of the real players */
+    uint64_t hash;               /**< Zobrist hash of the game state,
+                                      see @ref zobrist.h */
+    uint32_t threads;            /**< Number of threads scanning
+                                      the whole board, see
+                                      @ref gamma_set_threads */
+#ifdef GAMMA_STATS
+    GammaCounters stats;         /**< Counters of the work done,
+                                      see @ref stats.h */
+#endif
 } gamma_t;
 
 typedef struct Position {
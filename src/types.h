@@ -10,14 +10,32 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-struct FieldData;
+/** @brief Structure for storing owner's data
+ *
+ * For information on what "owner" is, check @ref gamma_t.
+ * For more information on @p busy_areas, check @ref are_in_the_same_area.
+ *
+ * For performance purposes, areas owned by the fake player are not count.
+ */
+typedef struct OwnerData OwnerData;
 
-/** @brief Pointer to the structure storing a field's data
+/** @brief Pointer to the structure storing an owner's data.
  */
-typedef struct FieldData *Field;
+typedef OwnerData *Owner;
+
+/** @brief Structure for storing the data of an area
+ *
+ * For information on the registry of the areas, check @ref areas.h.
+ */
+typedef struct AreaData AreaData;
 
-/** @brief Structure for storing field data
+/** @brief Pointer to the structure storing the data of an area.
+ */
+typedef AreaData *Area;
+
+/** @brief Structure for storing game data.
  *
+ * Each field of the board stores its owner.
  * By "owner" we mean either a real player (with index > 0)
  * or a fake player (with index == 0).
  *
@@ -28,25 +46,15 @@ typedef struct FieldData *Field;
  * by the fake player.
  *
  * By "player" we'll further mean a real player.
- */
-typedef struct FieldData FieldData;
-
-/** @brief Structure for storing owner's data
  *
- * For information on what "owner" is, check @ref FieldData.
- * For more information on @p busy_areas, check @ref are_in_the_same_area.
- *
- * For performance purposes, areas owned by the fake player are not count.
- */
-typedef struct OwnerData OwnerData;
-
-/** @brief Pointer to the structure storing an owner's data.
- */
-typedef OwnerData *Owner;
-
-/** @brief Structure for storing game data.
+ * The owners are stored in the narrowest of 8, 16 or 32 bits
+ * fitting all the players of the game, so that more fields
+ * fit in a cache line. The state of the flood fill is kept apart
+ * from them, in a bitmap of the thread running it (see @ref scratch.h),
+ * so that reading the board does not drag it along
+ * and any number of threads may search the board at once.
  *
- * @p players[0] stores the data of the fake player (see @ref FieldData).
+ * @p players[0] stores the data of the fake player.
  *
  * @p players[0]->busy_fields denotes the number of fields
  *                            which do not have a pawn on them.
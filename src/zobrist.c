@@ -0,0 +1,34 @@
+/** @file
+ * Implementation of the interface for computing the keys
+ * of the Zobrist hashing
+ *
+ * A table of random keys would need width * height * players entries,
+ * so instead the keys are computed by a strong 64-bit mixing function.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#include "zobrist.h"
+
+/** @brief Mixes the bits of @p x (the finalizer of SplitMix64).
+ *
+ * @return Pseudorandom value, distinct for distinct @p x.
+ */
+static uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30u)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27u)) * UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31u);
+}
+
+uint64_t zobrist_field(uint64_t cell, uint32_t owner) {
+    if (owner == 0)
+        return 0;
+    else
+        return mix(mix(cell) ^ owner);
+}
+
+uint64_t zobrist_golden(uint32_t player) {
+    // Fields and golden moves use different seeds,
+    // so their keys do not cancel out
+    return mix(mix(UINT64_C(0x9E3779B97F4A7C15)) ^ player);
+}
@@ -0,0 +1,33 @@
+/** @file
+ * Interface for computing the keys of the Zobrist hashing
+ *
+ * The hash of a game state is the XOR of the keys of all the pawns
+ * on the board and of all the used golden moves.
+ * The keys are derived from a fixed seed, so the same game state
+ * has the same hash in every process.
+ *
+ * @author Jakub Szulc <gihtub.com/j-szulc>
+ */
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+/** @brief Returns the key of a pawn.
+ *
+ * @param cell          – index of the field, see @ref cell_index
+ * @param owner         – zero or the index of the player
+ * @return Key of the pawn of @p owner standing on the field @p cell
+ *         or zero if @p owner == 0 (free fields do not change the hash).
+ */
+uint64_t zobrist_field(uint64_t cell, uint32_t owner);
+
+/** @brief Returns the key of a used golden move.
+ *
+ * @param player        – index of the player
+ * @return Key denoting that @p player has used his golden move.
+ */
+uint64_t zobrist_golden(uint32_t player);
+
+#endif //ZOBRIST_H